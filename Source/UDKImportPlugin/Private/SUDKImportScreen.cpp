@@ -1,6 +1,7 @@
 #include "SUDKImportScreen.h"
 #include "UDKImportPluginPrivatePCH.h"
 #include "T3DLevelParser.h"
+#include "UDKImportTask.h"
 
 #define LOCTEXT_NAMESPACE "UDKImportScreen"
 
@@ -100,6 +101,14 @@ void SUDKImportScreen::Construct(const FArguments& Args)
 			.FillHeight(1.0f)
 			.Padding(2.0f)
 			.VAlign(VAlign_Center)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("DryRunLabel", "Dry run"))
+			]
+			+ SVerticalBox::Slot()
+			.FillHeight(1.0f)
+			.Padding(2.0f)
+			.VAlign(VAlign_Center)
 		]
 		+ SHorizontalBox::Slot()
 		.FillWidth(2.0f)
@@ -137,6 +146,13 @@ void SUDKImportScreen::Construct(const FArguments& Args)
 			+ SVerticalBox::Slot()
 			.FillHeight(1.0f)
 			.Padding(2.0f)
+			[
+				SAssignNew(SDryRun, SCheckBox)
+				.ToolTipText(LOCTEXT("DryRun", "Only parse the files and look their references up in this project, nothing is created or compiled. The report goes to the Message Log and Saved/UDKImport/DryRun.json"))
+			]
+			+ SVerticalBox::Slot()
+			.FillHeight(1.0f)
+			.Padding(2.0f)
 			[
 				SNew(SButton)
 				.HAlign(HAlign_Center)
@@ -164,33 +180,35 @@ FReply SUDKImportScreen::OnRun()
 	DestPath.RemoveFromEnd("/");
 	DestPath.RemoveFromStart("/");
 	
+	if (FUDKImportTask::IsRunning())
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("ImportRunning", "An import is already running, wait for it to finish or cancel it first."));
+		return FReply::Handled();
+	}
+
+	TUniquePtr<T3DLevelParser> Parser = MakeUnique<T3DLevelParser>(SourcePath, DestPath);
+	if (SDryRun->IsChecked())
+	{
+		Parser->Settings.bDryRun = true;
+	}
 	switch (ExportMode)
 	{
 	case EUDKImportMode::Map:
-	{
-		T3DLevelParser Parser(SourcePath, DestPath);
-		Parser.ImportLevel();
+		Parser->BeginImportLevel();
 		break;
-	}
 	case EUDKImportMode::StaticMesh:
-	{
-		T3DLevelParser Parser(SourcePath, DestPath);
-		Parser.ImportStaticMesh();
+		Parser->BeginImportStaticMesh();
 		break;
-	}
 	case EUDKImportMode::Material:
-	{
-		T3DLevelParser Parser(SourcePath, DestPath);
-		Parser.ImportMaterial();
+		Parser->BeginImportMaterial();
 		break;
-	}
 	case EUDKImportMode::MaterialInstanceConstant:
-	{
-		T3DLevelParser Parser(SourcePath, DestPath);
-		Parser.ImportMaterialInstanceConstant();
+		Parser->BeginImportMaterialInstanceConstant();
 		break;
+	default:
+		return FReply::Handled();
 	}
-	}
+	FUDKImportTask::Start(MoveTemp(Parser));
 	
 	return FReply::Handled();
 }
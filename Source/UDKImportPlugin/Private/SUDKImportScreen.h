@@ -62,6 +62,9 @@ protected:
 	/** Path to the temporary directory to use */
 	TSharedPtr<SEditableTextBox> SDestPath;
 
+	/** Only analyze the sources */
+	TSharedPtr<SCheckBox> SDryRun;
+
 	/** Path to the temporary directory to use */
 	TSharedPtr<SComboBox< TSharedPtr<EUDKImportMode::Type> > > ExportTypeComboBox;
 
@@ -0,0 +1,387 @@
+#pragma once
+
+// Line level T3D parsing, shared by every T3D parser of the plugin.
+// Depends only on the C++ standard library: everything works on raw character ranges
+// and is templated on the character type, so it can be built and exercised outside the engine
+// (char on a plain compiler, TCHAR inside the plugin through T3DParser).
+
+#include <cmath>
+#include <cstddef>
+
+namespace T3DCore
+{
+	/** Half open range of characters, pointing inside the parsed line */
+	template<typename CharType>
+	struct TSpan
+	{
+		const CharType * Begin;
+		const CharType * End;
+
+		TSpan() : Begin(nullptr), End(nullptr)
+		{}
+
+		TSpan(const CharType * InBegin, const CharType * InEnd) : Begin(InBegin), End(InEnd)
+		{}
+
+		size_t Len() const
+		{
+			return End > Begin ? (size_t)(End - Begin) : 0;
+		}
+
+		bool IsEmpty() const
+		{
+			return Len() == 0;
+		}
+	};
+
+	/** Parts of a ressource url such as Type'Package.Group.Name' */
+	template<typename CharType>
+	struct TRessourceUrl
+	{
+		TSpan<CharType> Type;
+		/** Package and groups, empty when bHasPackage is false and the current package is meant */
+		TSpan<CharType> Package;
+		TSpan<CharType> Name;
+		bool bHasPackage;
+
+		TRessourceUrl() : bHasPackage(false)
+		{}
+	};
+
+	template<typename CharType>
+	inline bool IsWhitespace(CharType c)
+	{
+		return c == CharType(' ') || c == CharType('\t') || c == CharType('\r');
+	}
+
+	/** Whitespace skipped by atof : space, tab, line feed, vertical tab, form feed and carriage return */
+	template<typename CharType>
+	inline bool IsSpace(CharType c)
+	{
+		return c == CharType(' ') || (c >= CharType('\t') && c <= CharType('\r'));
+	}
+
+	template<typename CharType>
+	inline bool IsDigit(CharType c)
+	{
+		return c >= CharType('0') && c <= CharType('9');
+	}
+
+	template<typename CharType>
+	inline size_t Length(const CharType * String)
+	{
+		const CharType * End = String;
+		while (*End)
+		{
+			++End;
+		}
+		return (size_t)(End - String);
+	}
+
+	template<typename CharType>
+	inline bool StartsWith(const CharType * Begin, const CharType * End, const CharType * Prefix)
+	{
+		for (; *Prefix; ++Prefix, ++Begin)
+		{
+			if (Begin == End || *Begin != *Prefix)
+				return false;
+		}
+		return true;
+	}
+
+	template<typename CharType>
+	inline const CharType * Find(const CharType * Begin, const CharType * End, const CharType * Key, size_t KeyLen)
+	{
+		if (KeyLen == 0)
+			return Begin;
+
+		for (const CharType * Cursor = Begin; Cursor + KeyLen <= End; ++Cursor)
+		{
+			size_t Index = 0;
+			while (Index < KeyLen && Cursor[Index] == Key[Index])
+			{
+				++Index;
+			}
+			if (Index == KeyLen)
+				return Cursor;
+		}
+		return nullptr;
+	}
+
+	template<typename CharType>
+	inline const CharType * FindChar(const CharType * Begin, const CharType * End, CharType c)
+	{
+		for (; Begin < End; ++Begin)
+		{
+			if (*Begin == c)
+				return Begin;
+		}
+		return nullptr;
+	}
+
+	template<typename CharType>
+	inline const CharType * FindLastChar(const CharType * Begin, const CharType * End, CharType c)
+	{
+		while (End > Begin)
+		{
+			--End;
+			if (*End == c)
+				return End;
+		}
+		return nullptr;
+	}
+
+	/** Strips spaces, tabs and carriage returns on both sides */
+	template<typename CharType>
+	inline TSpan<CharType> Trim(const CharType * Begin, const CharType * End)
+	{
+		while (Begin < End && IsWhitespace(*Begin))
+		{
+			++Begin;
+		}
+		while (End > Begin && IsWhitespace(End[-1]))
+		{
+			--End;
+		}
+		return TSpan<CharType>(Begin, End);
+	}
+
+	/** How a trimmed line changes the object nesting : +1 for "Begin ", -1 for "End ", 0 otherwise */
+	template<typename CharType>
+	inline int LineDepthDelta(const CharType * Begin, const CharType * End)
+	{
+		static const CharType BeginPrefix[] = { 'B', 'e', 'g', 'i', 'n', ' ', 0 };
+		static const CharType EndPrefix[] = { 'E', 'n', 'd', ' ', 0 };
+		if (StartsWith(Begin, End, BeginPrefix))
+			return 1;
+		if (StartsWith(Begin, End, EndPrefix))
+			return -1;
+		return 0;
+	}
+
+	/**
+	 * Finds the first occurrence of Key and returns the value following it :
+	 * the content of a quoted string, a whole parenthesised group, or a token ended by ' ', ',' or ')'.
+	 * Fails when Key is missing or found after MaxIndex.
+	 */
+	template<typename CharType>
+	inline bool GetOneValueAfter(const CharType * Begin, const CharType * End, const CharType * Key, size_t KeyLen, TSpan<CharType> &Value, size_t MaxIndex = (size_t)-1)
+	{
+		const CharType * Start = Find(Begin, End, Key, KeyLen);
+		if (Start == nullptr || (size_t)(Start - Begin) > MaxIndex)
+			return false;
+
+		Start += KeyLen;
+		const CharType * Buffer = Start;
+		if (Buffer < End && *Buffer == CharType('"'))
+		{
+			++Start;
+			++Buffer;
+			bool Escaping = false;
+			while (Buffer < End && (*Buffer != CharType('"') || Escaping))
+			{
+				if (Escaping)
+					Escaping = false;
+				else if (*Buffer == CharType('\\'))
+					Escaping = true;
+				++Buffer;
+			}
+		}
+		else if (Buffer < End && *Buffer == CharType('('))
+		{
+			++Buffer;
+			int Level = 1;
+			while (Buffer < End && Level != 0)
+			{
+				if (*Buffer == CharType('('))
+					++Level;
+				else if (*Buffer == CharType(')'))
+					--Level;
+				++Buffer;
+			}
+		}
+		else
+		{
+			while (Buffer < End && *Buffer != CharType(' ') && *Buffer != CharType(',') && *Buffer != CharType(')'))
+			{
+				++Buffer;
+			}
+		}
+
+		Value = TSpan<CharType>(Start, Buffer);
+		return true;
+	}
+
+	/** Splits Name=Value on the first '=', the name must not be empty */
+	template<typename CharType>
+	inline bool IsProperty(const CharType * Begin, const CharType * End, TSpan<CharType> &Name, TSpan<CharType> &Value)
+	{
+		const CharType * Equal = FindChar(Begin, End, CharType('='));
+		if (Equal == nullptr || Equal == Begin)
+			return false;
+
+		Name = TSpan<CharType>(Begin, Equal);
+		Value = TSpan<CharType>(Equal + 1, End);
+		return true;
+	}
+
+	/** Splits Package.Group.Name on the last '.', without package the whole string is the name */
+	template<typename CharType>
+	inline void SplitPackagePath(const CharType * Begin, const CharType * End, TSpan<CharType> &Package, TSpan<CharType> &Name, bool &bHasPackage)
+	{
+		const CharType * Dot = FindLastChar(Begin, End, CharType('.'));
+		bHasPackage = Dot != nullptr;
+		if (bHasPackage)
+		{
+			Package = TSpan<CharType>(Begin, Dot);
+			Name = TSpan<CharType>(Dot + 1, End);
+		}
+		else
+		{
+			Package = TSpan<CharType>(End, End);
+			Name = TSpan<CharType>(Begin, End);
+		}
+	}
+
+	/** Parses Type'Package.Group.Name' or Type'Name' */
+	template<typename CharType>
+	inline bool ParseRessourceUrl(const CharType * Begin, const CharType * End, TRessourceUrl<CharType> &Url)
+	{
+		const CharType * Quote = FindChar(Begin, End, CharType('\''));
+		if (Quote == nullptr || End == Begin || End[-1] != CharType('\''))
+			return false;
+
+		Url.Type = TSpan<CharType>(Begin, Quote);
+		const CharType * PathBegin = Quote + 1;
+		const CharType * PathEnd = End - 1 > PathBegin ? End - 1 : PathBegin;
+		SplitPackagePath(PathBegin, PathEnd, Url.Package, Url.Name, Url.bHasPackage);
+		return true;
+	}
+
+	/**
+	 * Decimal floating point number with optional sign and exponent, like atof : leading whitespace is skipped and 0 is returned when nothing parses.
+	 * The first 19 significant digits are kept and scaled by a single power of ten, exponents beyond the range of double
+	 * give 0 or infinity without looping over them
+	 */
+	template<typename CharType>
+	inline double ParseFloat(const CharType * Stream, const CharType ** OutEnd = nullptr)
+	{
+		static const int MaxDigits = 19;
+		static const long long MaxExponent = 100000;
+
+		while (IsSpace(*Stream))
+		{
+			++Stream;
+		}
+
+		const CharType * Start = Stream;
+		bool bNegative = false;
+		if (*Stream == CharType('-') || *Stream == CharType('+'))
+		{
+			bNegative = *Stream == CharType('-');
+			++Stream;
+		}
+
+		// Digits past MaxDigits only move the decimal point, they are below the precision of a double anyway
+		unsigned long long Mantissa = 0;
+		int Digits = 0;
+		long long Exponent = 0;
+		bool bDigits = false;
+		for (; IsDigit(*Stream); ++Stream, bDigits = true)
+		{
+			if (Digits < MaxDigits)
+			{
+				Mantissa = Mantissa * 10 + (*Stream - CharType('0'));
+				Digits += Mantissa != 0;
+			}
+			else if (Exponent < MaxExponent)
+			{
+				++Exponent;
+			}
+		}
+		if (*Stream == CharType('.'))
+		{
+			++Stream;
+			for (; IsDigit(*Stream); ++Stream, bDigits = true)
+			{
+				if (Digits < MaxDigits && Exponent > -MaxExponent)
+				{
+					Mantissa = Mantissa * 10 + (*Stream - CharType('0'));
+					Digits += Mantissa != 0;
+					--Exponent;
+				}
+			}
+		}
+
+		if (!bDigits)
+		{
+			if (OutEnd)
+				*OutEnd = Start;
+			return 0.0;
+		}
+
+		if (*Stream == CharType('e') || *Stream == CharType('E'))
+		{
+			const CharType * ExponentStream = Stream + 1;
+			bool bNegativeExponent = false;
+			if (*ExponentStream == CharType('-') || *ExponentStream == CharType('+'))
+			{
+				bNegativeExponent = *ExponentStream == CharType('-');
+				++ExponentStream;
+			}
+			if (IsDigit(*ExponentStream))
+			{
+				long long Power = 0;
+				for (; IsDigit(*ExponentStream); ++ExponentStream)
+				{
+					if (Power < MaxExponent)
+						Power = Power * 10 + (*ExponentStream - CharType('0'));
+				}
+				Exponent += bNegativeExponent ? -Power : Power;
+				Stream = ExponentStream;
+			}
+		}
+
+		if (OutEnd)
+			*OutEnd = Stream;
+
+		double Value = (double)Mantissa;
+		if (Mantissa != 0 && Exponent > 0)
+		{
+			Value *= std::pow(10.0, (double)(Exponent < MaxExponent ? Exponent : MaxExponent));
+		}
+		else if (Mantissa != 0 && Exponent < 0)
+		{
+			// Dividing keeps exact powers of ten exact, the first step lets denormals through
+			if (Exponent < -300)
+			{
+				Value /= 1e300;
+				Exponent += 300;
+			}
+			Value /= std::pow(10.0, (double)(Exponent > -MaxExponent ? -Exponent : MaxExponent));
+		}
+		return bNegative ? -Value : Value;
+	}
+
+	/** Parses X,Y,Z as written after ORIGIN, VERTEX, NORMAL... Components that are missing stay at 0 */
+	template<typename CharType>
+	inline bool ParseVector(const CharType * Stream, double &X, double &Y, double &Z)
+	{
+		X = Y = Z = 0.0;
+
+		X = ParseFloat(Stream);
+		Stream = FindChar(Stream, Stream + Length(Stream), CharType(','));
+		if (!Stream)
+			return false;
+
+		++Stream;
+		Y = ParseFloat(Stream);
+		Stream = FindChar(Stream, Stream + Length(Stream), CharType(','));
+		if (!Stream)
+			return false;
+
+		++Stream;
+		Z = ParseFloat(Stream);
+		return true;
+	}
+}
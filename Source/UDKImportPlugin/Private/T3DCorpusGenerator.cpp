@@ -0,0 +1,285 @@
+#include "T3DCorpusGenerator.h"
+#include "UDKImportPluginPrivatePCH.h"
+
+T3DCorpusGenerator::FSettings::FSettings()
+	: Packages(4)
+	, Materials(100)
+	, ExpressionsPerMaterial(20)
+	, InstanceChains(100)
+	, InstanceDepth(3)
+	, StaticMeshActors(1000)
+	, Brushes(50)
+	, Lights(100)
+	, Seed(0)
+{
+}
+
+T3DCorpusGenerator::T3DCorpusGenerator(const FSettings &Settings)
+	: Settings(Settings)
+	, Random(Settings.Seed)
+	, PeakUsedPhysical(0)
+{
+}
+
+bool T3DCorpusGenerator::Generate(const FString &InOutputPath)
+{
+	OutputPath = InOutputPath;
+	Random.Initialize(Settings.Seed);
+	PeakUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	MaterialParameters.Reset(Settings.Materials);
+	MaterialParameters.SetNum(Settings.Materials);
+
+	for (int32 Index = 0; Index < Settings.Materials; ++Index)
+	{
+		if (!GenerateMaterial(Index))
+			return false;
+	}
+
+	for (int32 Index = 0; Index < Settings.InstanceChains && Settings.Materials > 0; ++Index)
+	{
+		if (!GenerateInstanceChain(Index))
+			return false;
+	}
+
+	return GenerateLevel();
+}
+
+FString T3DCorpusGenerator::PackageName(int32 Index) const
+{
+	return FString::Printf(TEXT("Synthetic%d"), Index % FMath::Max(Settings.Packages, 1));
+}
+
+FString T3DCorpusGenerator::MaterialName(int32 Index) const
+{
+	return FString::Printf(TEXT("M_Synthetic_%d"), Index);
+}
+
+FString T3DCorpusGenerator::MaterialUrl(int32 Index) const
+{
+	return FString::Printf(TEXT("Material'%s.Materials.%s'"), *PackageName(Index), *MaterialName(Index));
+}
+
+bool T3DCorpusGenerator::Save(const FString &Package, const FString &Group, const FString &Name, const FString &Content)
+{
+	FString FileName = OutputPath / Package / Group / Name + TEXT(".T3D");
+	SampleMemory();
+	if (!FFileHelper::SaveStringToFile(Content, *FileName))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to write %s"), *FileName);
+		return false;
+	}
+	return true;
+}
+
+void T3DCorpusGenerator::SampleMemory()
+{
+	// Sampled right before a write, while the generated text of the file is still alive
+	PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+}
+
+bool T3DCorpusGenerator::GenerateMaterial(int32 Index)
+{
+	// Leaves first (constants, parameters, coordinates), then operators reading from earlier expressions
+	static const TCHAR * Leaves[] = { TEXT("MaterialExpressionConstant"), TEXT("MaterialExpressionConstant3Vector"), TEXT("MaterialExpressionScalarParameter"), TEXT("MaterialExpressionVectorParameter"), TEXT("MaterialExpressionTextureCoordinate") };
+	static const TCHAR * Operators[] = { TEXT("MaterialExpressionMultiply"), TEXT("MaterialExpressionAdd"), TEXT("MaterialExpressionLinearInterpolate") };
+
+	const int32 NumExpressions = FMath::Max(Settings.ExpressionsPerMaterial, 1);
+	const int32 NumLeaves = FMath::Max(NumExpressions / 2, 1);
+	TArray<FString> Names;
+	FString Out = FString::Printf(TEXT("Begin Object Class=Material Name=%s\r\n"), *MaterialName(Index));
+
+	for (int32 Expression = 0; Expression < NumExpressions; ++Expression)
+	{
+		const TCHAR * Class = Expression < NumLeaves ? Leaves[Random.RandHelper(UE_ARRAY_COUNT(Leaves))] : Operators[Random.RandHelper(UE_ARRAY_COUNT(Operators))];
+		FString Name = FString::Printf(TEXT("%s_%d"), Class, Expression);
+		Out += FString::Printf(TEXT("   Begin Object Class=%s Name=%s\r\n"), Class, *Name);
+
+		if (Expression < NumLeaves)
+		{
+			if (Class == Leaves[0])
+			{
+				Out += FString::Printf(TEXT("      R=%f\r\n"), Random.FRand());
+			}
+			else if (Class == Leaves[1])
+			{
+				Out += FString::Printf(TEXT("      R=%f\r\n      G=%f\r\n      B=%f\r\n"), Random.FRand(), Random.FRand(), Random.FRand());
+			}
+			else if (Class == Leaves[2])
+			{
+				FString ParameterName = FString::Printf(TEXT("Scalar_%d"), Expression);
+				MaterialParameters[Index].Add(ParameterName);
+				Out += FString::Printf(TEXT("      DefaultValue=%f\r\n      ParameterName=\"%s\"\r\n"), Random.FRand(), *ParameterName);
+			}
+			else if (Class == Leaves[3])
+			{
+				Out += FString::Printf(TEXT("      DefaultValue=(R=%f,G=%f,B=%f,A=1.000000)\r\n      ParameterName=\"Vector_%d\"\r\n"), Random.FRand(), Random.FRand(), Random.FRand(), Expression);
+			}
+			else
+			{
+				Out += FString::Printf(TEXT("      UTiling=%f\r\n      VTiling=%f\r\n"), Random.FRandRange(1.f, 8.f), Random.FRandRange(1.f, 8.f));
+			}
+		}
+		else
+		{
+			Out += FString::Printf(TEXT("      A=(Expression=%s)\r\n"), *Names[Random.RandHelper(Names.Num())]);
+			Out += FString::Printf(TEXT("      B=(Expression=%s)\r\n"), *Names[Random.RandHelper(Names.Num())]);
+			if (Class == Operators[2])
+			{
+				Out += FString::Printf(TEXT("      Alpha=(Expression=%s)\r\n"), *Names[Random.RandHelper(Names.Num())]);
+			}
+		}
+
+		Out += FString::Printf(TEXT("      Material=%s\r\n"), *MaterialUrl(Index));
+		Out += FString::Printf(TEXT("      EditorX=%d\r\n      EditorY=%d\r\n"), -200 * (NumExpressions - Expression), 64 * (Expression % 16));
+		Out += FString::Printf(TEXT("      Name=\"%s\"\r\n"), *Name);
+		Out += FString::Printf(TEXT("      ObjectArchetype=%s'Engine.Default__%s'\r\n"), Class, Class);
+		Out += TEXT("   End Object\r\n");
+
+		Names.Add(FString::Printf(TEXT("%s'%s'"), Class, *Name));
+	}
+
+	Out += FString::Printf(TEXT("   DiffuseColor=(Expression=%s)\r\n"), *Names.Last());
+	Out += FString::Printf(TEXT("   EmissiveColor=(Expression=%s)\r\n"), *Names[Random.RandHelper(Names.Num())]);
+	for (int32 Expression = 0; Expression < Names.Num(); ++Expression)
+	{
+		Out += FString::Printf(TEXT("   Expressions(%d)=%s\r\n"), Expression, *Names[Expression]);
+	}
+	Out += FString::Printf(TEXT("   Name=\"%s\"\r\n"), *MaterialName(Index));
+	Out += TEXT("   ObjectArchetype=Material'Engine.Default__Material'\r\n");
+	Out += TEXT("End Object\r\n");
+
+	return Save(PackageName(Index), TEXT("Materials"), MaterialName(Index), Out);
+}
+
+bool T3DCorpusGenerator::GenerateInstanceChain(int32 Index)
+{
+	const int32 MaterialIndex = Random.RandHelper(Settings.Materials);
+	const TArray<FString> &Parameters = MaterialParameters[MaterialIndex];
+	const FString Package = PackageName(Index);
+	FString ParentUrl = MaterialUrl(MaterialIndex);
+
+	for (int32 Depth = 0; Depth < FMath::Max(Settings.InstanceDepth, 1); ++Depth)
+	{
+		FString Name = FString::Printf(TEXT("MI_Synthetic_%d_%d"), Index, Depth);
+		FString Out = FString::Printf(TEXT("Begin Object Class=MaterialInstanceConstant Name=%s\r\n"), *Name);
+
+		// Every level of the chain overrides a few of the parameters of the base material
+		int32 NumOverrides = FMath::Min(Parameters.Num(), 1 + Random.RandHelper(3));
+		for (int32 Override = 0; Override < NumOverrides; ++Override)
+		{
+			Out += FString::Printf(TEXT("   ScalarParameterValues(%d)=(ParameterName=\"%s\",ParameterValue=%f,ExpressionGUID=%s)\r\n"), Override, *Parameters[Random.RandHelper(Parameters.Num())], Random.FRand(), *FGuid().ToString());
+		}
+		Out += FString::Printf(TEXT("   Parent=%s\r\n"), *ParentUrl);
+		Out += FString::Printf(TEXT("   Name=\"%s\"\r\n"), *Name);
+		Out += TEXT("   ObjectArchetype=MaterialInstanceConstant'Engine.Default__MaterialInstanceConstant'\r\n");
+		Out += TEXT("End Object\r\n");
+
+		if (!Save(Package, TEXT("Instances"), Name, Out))
+			return false;
+
+		ParentUrl = FString::Printf(TEXT("MaterialInstanceConstant'%s.Instances.%s'"), *Package, *Name);
+	}
+
+	return true;
+}
+
+bool T3DCorpusGenerator::GenerateLevel()
+{
+	FString Out = TEXT("Begin Object Class=Level Name=PersistentLevel\r\n");
+	for (int32 Index = 0; Index < Settings.StaticMeshActors; ++Index)
+	{
+		AppendStaticMeshActor(Out, Index);
+	}
+	for (int32 Index = 0; Index < Settings.Brushes; ++Index)
+	{
+		AppendBrush(Out, Index);
+	}
+	for (int32 Index = 0; Index < Settings.Lights; ++Index)
+	{
+		AppendPointLight(Out, Index);
+	}
+	Out += TEXT("End Object\r\n");
+
+	FString FileName = OutputPath / TEXT("PersistentLevel.T3D");
+	SampleMemory();
+	if (!FFileHelper::SaveStringToFile(Out, *FileName))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to write %s"), *FileName);
+		return false;
+	}
+	return true;
+}
+
+FString T3DCorpusGenerator::RandomLocation()
+{
+	return FString::Printf(TEXT("(X=%f,Y=%f,Z=%f)"), Random.FRandRange(-65536.f, 65536.f), Random.FRandRange(-65536.f, 65536.f), Random.FRandRange(-4096.f, 4096.f));
+}
+
+void T3DCorpusGenerator::AppendStaticMeshActor(FString &Out, int32 Index)
+{
+	Out += FString::Printf(TEXT("   Begin Object Class=StaticMeshActor Name=StaticMeshActor_%d\r\n"), Index);
+	Out += TEXT("      Begin Object Class=StaticMeshComponent Name=StaticMeshComponent0 ObjName=StaticMeshComponent_0 Archetype=StaticMeshComponent'Engine.Default__StaticMeshActor:StaticMeshComponent0'\r\n");
+	Out += FString::Printf(TEXT("         StaticMesh=StaticMesh'%s.Meshes.SM_Synthetic_%d'\r\n"), *PackageName(Index), Index % 32);
+	Out += FString::Printf(TEXT("         Materials(0)=%s\r\n"), *MaterialUrl(Random.RandHelper(FMath::Max(Settings.Materials, 1))));
+	Out += TEXT("         Name=\"StaticMeshComponent_0\"\r\n");
+	Out += TEXT("      End Object\r\n");
+	Out += FString::Printf(TEXT("      Location=%s\r\n"), *RandomLocation());
+	Out += FString::Printf(TEXT("      Rotation=(Pitch=0,Yaw=%d,Roll=0)\r\n"), Random.RandHelper(65536));
+	Out += FString::Printf(TEXT("      DrawScale=%f\r\n"), Random.FRandRange(0.5f, 2.f));
+	Out += TEXT("      Layer=\"Synthetic\"\r\n");
+	Out += FString::Printf(TEXT("      Name=\"StaticMeshActor_%d\"\r\n"), Index);
+	Out += TEXT("   End Object\r\n");
+}
+
+void T3DCorpusGenerator::AppendBrush(FString &Out, int32 Index)
+{
+	// Axis aligned box, six quads
+	static const int32 Faces[6][4] = { { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 } };
+	static const FVector Normals[6] = { FVector(-1, 0, 0), FVector(1, 0, 0), FVector(0, -1, 0), FVector(0, 1, 0), FVector(0, 0, -1), FVector(0, 0, 1) };
+	const float Size = Random.FRandRange(64.f, 1024.f);
+	FVector Corners[8];
+	for (int32 Corner = 0; Corner < 8; ++Corner)
+	{
+		Corners[Corner] = FVector(Corner & 4 ? Size : -Size, Corner & 2 ? Size : -Size, Corner & 1 ? Size : -Size);
+	}
+
+	Out += FString::Printf(TEXT("   Begin Object Class=Brush Name=Brush_%d\r\n"), Index);
+	Out += FString::Printf(TEXT("      Begin Brush Name=Model_%d\r\n"), Index);
+	Out += TEXT("         Begin PolyList\r\n");
+	for (int32 Face = 0; Face < 6; ++Face)
+	{
+		const FVector &Origin = Corners[Faces[Face][0]];
+		FVector TextureU = (Corners[Faces[Face][1]] - Origin).GetSafeNormal();
+		FVector TextureV = Normals[Face] ^ TextureU;
+		Out += FString::Printf(TEXT("            Begin Polygon Texture=%s.Materials.%s Link=%d\r\n"), *PackageName(Index), *MaterialName(Random.RandHelper(FMath::Max(Settings.Materials, 1))), Face);
+		Out += FString::Printf(TEXT("               Origin   %+013.6f,%+013.6f,%+013.6f\r\n"), Origin.X, Origin.Y, Origin.Z);
+		Out += FString::Printf(TEXT("               Normal   %+013.6f,%+013.6f,%+013.6f\r\n"), Normals[Face].X, Normals[Face].Y, Normals[Face].Z);
+		Out += FString::Printf(TEXT("               TextureU %+013.6f,%+013.6f,%+013.6f\r\n"), TextureU.X, TextureU.Y, TextureU.Z);
+		Out += FString::Printf(TEXT("               TextureV %+013.6f,%+013.6f,%+013.6f\r\n"), TextureV.X, TextureV.Y, TextureV.Z);
+		for (int32 Vertex = 0; Vertex < 4; ++Vertex)
+		{
+			const FVector &Position = Corners[Faces[Face][Vertex]];
+			Out += FString::Printf(TEXT("               Vertex   %+013.6f,%+013.6f,%+013.6f\r\n"), Position.X, Position.Y, Position.Z);
+		}
+		Out += TEXT("            End Polygon\r\n");
+	}
+	Out += TEXT("         End PolyList\r\n");
+	Out += TEXT("      End Brush\r\n");
+	Out += FString::Printf(TEXT("      CsgOper=%s\r\n"), Random.RandHelper(4) == 0 ? TEXT("CSG_Subtract") : TEXT("CSG_Add"));
+	Out += FString::Printf(TEXT("      Location=%s\r\n"), *RandomLocation());
+	Out += FString::Printf(TEXT("      Name=\"Brush_%d\"\r\n"), Index);
+	Out += TEXT("   End Object\r\n");
+}
+
+void T3DCorpusGenerator::AppendPointLight(FString &Out, int32 Index)
+{
+	Out += FString::Printf(TEXT("   Begin Object Class=PointLight Name=PointLight_%d\r\n"), Index);
+	Out += TEXT("      Begin Object Class=PointLightComponent Name=PointLightComponent0 ObjName=PointLightComponent_0 Archetype=PointLightComponent'Engine.Default__PointLight:PointLightComponent0'\r\n");
+	Out += FString::Printf(TEXT("         Radius=%f\r\n"), Random.FRandRange(256.f, 4096.f));
+	Out += FString::Printf(TEXT("         Brightness=%f\r\n"), Random.FRandRange(0.5f, 4.f));
+	Out += FString::Printf(TEXT("         LightColor=(B=%d,G=%d,R=%d,A=0)\r\n"), Random.RandHelper(256), Random.RandHelper(256), Random.RandHelper(256));
+	Out += TEXT("      End Object\r\n");
+	Out += FString::Printf(TEXT("      Location=%s\r\n"), *RandomLocation());
+	Out += FString::Printf(TEXT("      Name=\"PointLight_%d\"\r\n"), Index);
+	Out += TEXT("   End Object\r\n");
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Writes a synthetic UDK T3D export tree, laid out like a real UDK batch export,
+ * so import throughput can be measured and shared without proprietary content.
+ */
+class T3DCorpusGenerator
+{
+public:
+	struct FSettings
+	{
+		/** Packages the assets are spread over, one directory each */
+		int32 Packages;
+		int32 Materials;
+		int32 ExpressionsPerMaterial;
+		/** Number of MaterialInstanceConstant chains and the depth of each of them */
+		int32 InstanceChains;
+		int32 InstanceDepth;
+		int32 StaticMeshActors;
+		int32 Brushes;
+		int32 Lights;
+		int32 Seed;
+
+		FSettings();
+	};
+
+	T3DCorpusGenerator(const FSettings &Settings);
+
+	/** Writes the corpus under OutputPath, PersistentLevel.T3D at its root */
+	bool Generate(const FString &OutputPath);
+
+	/** Highest used physical memory sampled while the last Generate call held a file in memory */
+	uint64 GetPeakUsedPhysical() const { return PeakUsedPhysical; }
+
+private:
+	FSettings Settings;
+	FRandomStream Random;
+	FString OutputPath;
+	uint64 PeakUsedPhysical;
+
+	/// Scalar parameter names of each generated material, used by the instances
+	TArray<TArray<FString> > MaterialParameters;
+
+	FString PackageName(int32 Index) const;
+	FString MaterialName(int32 Index) const;
+	FString MaterialUrl(int32 Index) const;
+	bool Save(const FString &Package, const FString &Group, const FString &Name, const FString &Content);
+	void SampleMemory();
+
+	bool GenerateMaterial(int32 Index);
+	bool GenerateInstanceChain(int32 Index);
+	bool GenerateLevel();
+	void AppendStaticMeshActor(FString &Out, int32 Index);
+	void AppendBrush(FString &Out, int32 Index);
+	void AppendPointLight(FString &Out, int32 Index);
+	FString RandomLocation();
+};
@@ -3,6 +3,18 @@
 #include "Editor/UnrealEd/Public/BSPOps.h"
 #include "Runtime/Engine/Public/ComponentReregisterContext.h"
 #include "Runtime/Engine/Classes/Sound/SoundNode.h"
+#include "ShaderCompiler.h"
+#include "Serialization/JsonWriter.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "ObjectTools.h"
+#include "PackageTools.h"
+#include "AssetRegistryModule.h"
+#include "HierarchicalLODUtilitiesModule.h"
+#include "IHierarchicalLODUtilities.h"
+#include "Engine/LODActor.h"
+#include "StaticMeshAttributes.h"
+#include "T3DCore/T3DLineParser.h"
 #include "T3DMaterialParser.h"
 #include "T3DMaterialInstanceConstantParser.h"
 
@@ -11,6 +23,23 @@
 T3DLevelParser::T3DLevelParser(const FString &SourcePath, const FString &DestPath) : T3DParser(SourcePath, DestPath)
 {
 	this->World = NULL;
+	this->Diagnostics = &ImportDiagnostics;
+	this->Phase = EImportPhase::Done;
+	this->PhaseIndex = 0;
+	this->FinalizeStep = EFinalizeStep::PrepareAssets;
+	this->bFinalizeStepStarted = false;
+	this->bPhaseImportedAssets = false;
+	this->bCancelRequested = false;
+	this->bLevelFileOpen = false;
+	this->TotalBytes = 0;
+	this->ProcessedBytes = 0;
+	this->FilePhaseStartTime = 0.;
+	this->SaveIndex = 0;
+	this->bPhaseStarted = false;
+	this->PhasePeakUsedPhysical = 0;
+	this->SavedPackages = 0;
+	this->ReportDirectory = FPaths::ProjectSavedDir() / TEXT("UDKImport");
+	Settings.LoadConfig();
 }
 
 template<class T>
@@ -18,270 +47,1905 @@ T * T3DLevelParser::SpawnActor()
 {
 	if (World == NULL)
 	{
-		FLevelEditorModule & LevelEditorModule = FModuleManager::LoadModuleChecked<FLevelEditorModule>("LevelEditor");
-		World = LevelEditorModule.GetFirstLevelEditor().Get()->GetWorld();
+		if (IsRunningCommandlet())
+		{
+			// No level editor without the UI
+			World = GEditor->GetEditorWorldContext().World();
+		}
+		else
+		{
+			FLevelEditorModule & LevelEditorModule = FModuleManager::LoadModuleChecked<FLevelEditorModule>("LevelEditor");
+			World = LevelEditorModule.GetFirstLevelEditor().Get()->GetWorld();
+		}
 	}
 	ensure(World != NULL);
 
-	return World->SpawnActor<T>();
+	T * Actor = World->SpawnActor<T>();
+	SpawnedActors.Add(Actor);
+	return Actor;
+}
+
+void T3DLevelParser::SetWorld(UWorld * InWorld)
+{
+	World = InWorld;
+}
+
+bool T3DLevelParser::WriteSummary(const FString &FileName) const
+{
+	TMap<FString, int32> ImportedByType;
+	for (auto Iter = FixedRequirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		ImportedByType.FindOrAdd(Iter.Key().Type)++;
+	}
+
+	FString Json;
+	TSharedRef<TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("source"), SourcePath);
+	Writer->WriteValue(TEXT("destination"), DestPath);
+	Writer->WriteObjectStart(TEXT("imported"));
+	for (auto Iter = ImportedByType.CreateConstIterator(); Iter; ++Iter)
+	{
+		Writer->WriteValue(Iter.Key(), Iter.Value());
+	}
+	Writer->WriteObjectEnd();
+	Writer->WriteValue(TEXT("saved"), SavedPackages);
+	Writer->WriteArrayStart(TEXT("saveFailures"));
+	for (const FString &Package : SaveFailures)
+	{
+		Writer->WriteValue(Package);
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteArrayStart(TEXT("missing"));
+	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		Writer->WriteValue(Iter.Key().Url);
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteArrayStart(TEXT("incomplete"));
+	for (const FString &File : IncompleteFiles)
+	{
+		Writer->WriteValue(File);
+	}
+	Writer->WriteArrayEnd();
+	ImportDiagnostics.WriteEntries(*Writer, TEXT("messages"));
+	if (bDryRun)
+		WriteDryRun(*Writer);
+	Writer->WriteArrayStart(TEXT("memory"));
+	for (const FMemorySnapshot &Snapshot : MemorySnapshots)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("phase"), Snapshot.Phase);
+		Writer->WriteValue(TEXT("usedBytes"), (int64)Snapshot.UsedPhysical);
+		Writer->WriteValue(TEXT("phasePeakBytes"), (int64)Snapshot.PhasePeakUsedPhysical);
+		Writer->WriteValue(TEXT("processPeakBytes"), (int64)Snapshot.PeakUsedPhysical);
+		Writer->WriteValue(TEXT("parserBytes"), Snapshot.ParserBytes);
+		Writer->WriteValue(TEXT("requirementBytes"), Snapshot.RequirementBytes);
+		Writer->WriteValue(TEXT("pendingDelegates"), Snapshot.PendingDelegates);
+		Writer->WriteValue(TEXT("cacheBytes"), Snapshot.CacheBytes);
+		Writer->WriteValue(TEXT("createdObjects"), Snapshot.CreatedObjects);
+		Writer->WriteValue(TEXT("createdObjectBytes"), Snapshot.CreatedObjectBytes);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	return FFileHelper::SaveStringToFile(Json, *FileName);
+}
+
+void T3DLevelParser::ImportLevel()
+{
+	BeginImportLevel();
+	RunImport(LOCTEXT("StatusBeginLevel", "Importing requested level"));
+}
+
+void T3DLevelParser::ImportStaticMesh()
+{
+	BeginImportStaticMesh();
+	RunImport(LOCTEXT("StatusBeginMaterialRessouces", "Scanning files"));
+}
+
+void T3DLevelParser::ImportMaterial()
+{
+	BeginImportMaterial();
+	RunImport(LOCTEXT("StatusBeginMaterialRessouces", "Scanning files"));
+}
+
+void T3DLevelParser::ImportMaterialInstanceConstant()
+{
+	BeginImportMaterialInstanceConstant();
+	RunImport(LOCTEXT("StatusBeginMaterialRessouces", "Scanning files"));
+}
+
+void T3DLevelParser::BeginImportLevel()
+{
+	BuildSourceIndex();
+	BeginImport(EImportPhase::Level);
+}
+
+void T3DLevelParser::BeginImportStaticMesh()
+{
+	BeginImportRessource(EExportType::StaticMesh);
+}
+
+void T3DLevelParser::BeginImportMaterial()
+{
+	BeginImportRessource(EExportType::Material);
+}
+
+void T3DLevelParser::BeginImportMaterialInstanceConstant()
+{
+	BeginImportRessource(EExportType::MaterialInstanceConstant);
+}
+
+void T3DLevelParser::BeginImportRessource(EExportType::Type Type)
+{
+	BuildSourceIndex();
+	ExportPackageToRequirements(Type);
+	BeginImport(EImportPhase::Materials);
+}
+
+void T3DLevelParser::BeginImport(EImportPhase::Type FirstPhase)
+{
+	bDryRun = Settings.bDryRun;
+	if (bDryRun)
+	{
+		// Every reference is checked against the registry, it has to know the whole project
+		IAssetRegistry &AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+		if (AssetRegistry.IsLoadingAssets())
+		{
+			AssetRegistry.SearchAllAssets(true);
+		}
+	}
+	else
+	{
+		PreloadSubstitutions();
+	}
+	bCancelRequested = false;
+	TotalBytes = 0;
+	ProcessedBytes = 0;
+	FilePhaseStartTime = FPlatformTime::Seconds();
+	EnterPhase(FirstPhase);
+}
+
+void T3DLevelParser::RunImport(const FText &Title)
+{
+	GWarn->BeginSlowTask(Title, true, true);
+	while (!TickImport(0.1))
+	{
+		GWarn->StatusUpdate(FMath::RoundToInt(GetImportProgress() * 1000.f), 1000, GetImportStatus());
+		if (GWarn->ReceivedUserCancel())
+		{
+			CancelImport();
+		}
+	}
+	GWarn->EndSlowTask();
+}
+
+bool T3DLevelParser::TickImport(double TimeBudget)
+{
+	// Nothing done by a bulk import is recorded, even when it runs inside a transaction
+	TGuardValue<ITransaction*> UndoGuard(GUndo, Settings.bBulkImport ? NULL : GUndo);
+	const double EndTime = FPlatformTime::Seconds() + TimeBudget;
+	do
+	{
+		// Saved packages can not be taken back, the import can be cancelled until saving starts
+		if (bCancelRequested && (Phase < EImportPhase::Finalize || (Phase == EImportPhase::Finalize && FinalizeStep < EFinalizeStep::SavePackages)))
+		{
+			RollbackImport();
+			Phase = EImportPhase::Cancelled;
+		}
+		if (Phase == EImportPhase::Done || Phase == EImportPhase::Cancelled)
+			return true;
+
+		StepImport();
+	} while (FPlatformTime::Seconds() < EndTime);
+
+	return Phase == EImportPhase::Done || Phase == EImportPhase::Cancelled;
+}
+
+void T3DLevelParser::CancelImport()
+{
+	bCancelRequested = true;
+}
+
+bool T3DLevelParser::IsImportCancelled() const
+{
+	return Phase == EImportPhase::Cancelled;
+}
+
+void T3DLevelParser::EnterPhase(EImportPhase::Type NewPhase)
+{
+	if (bPhaseStarted)
+		SnapshotMemory();
+	bPhaseStarted = true;
+	PhasePeakUsedPhysical = 0;
+
+	Phase = NewPhase;
+	PhaseQueue.Reset();
+	PhaseIndex = 0;
+	FinalizeStep = EFinalizeStep::PrepareAssets;
+	bFinalizeStepStarted = false;
+	bPhaseImportedAssets = false;
+
+	FString FileType;
+	if (Phase == EImportPhase::Materials)
+	{
+		RetypeRequirementsFromSource();
+		FileType = TEXT("Material");
+	}
+	else if (Phase == EImportPhase::MaterialInstanceConstants)
+		FileType = TEXT("MaterialInstanceConstant");
+	else if (Phase != EImportPhase::ResolveLinks)
+		return;
+
+	// Steps add and fix requirements, work on a copy
+	UDKIMPORT_LLM_SCOPE(Requirements);
+	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		const FRequirement &Requirement = Iter.Key();
+		if (!FileType.IsEmpty() && (Requirement.Type != FileType || FailedImports.Contains(Requirement.Url)))
+			continue;
+
+		const FString FileName = FileType.IsEmpty() ? FString() : GetPathToT3D(Requirement.RelDirectory, Requirement.Name);
+		if (ShardFiles.Num() > 0 && !FileName.IsEmpty() && !ShardFiles.Contains(FileName))
+		{
+			// Another shard imports it, the final pass links to it
+			continue;
+		}
+
+		FQueuedRequirement &Queued = PhaseQueue[PhaseQueue.AddDefaulted()];
+		Queued.Requirement = Requirement;
+		Queued.Bytes = 0;
+		if (!FileType.IsEmpty())
+		{
+			Queued.FileName = FileName;
+			Queued.Bytes = FMath::Max<int64>(IFileManager::Get().FileSize(*Queued.FileName), 0);
+			TotalBytes += Queued.Bytes;
+		}
+	}
+}
+
+void T3DLevelParser::StepImport()
+{
+	PhasePeakUsedPhysical = FMath::Max<uint64>(PhasePeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+	switch (Phase)
+	{
+	case EImportPhase::Level:
+		if (bDryRun)
+			AnalyzeLevelFile();
+		else if (!bLevelFileOpen)
+			bLevelFileOpen = BeginImportLevelFile();
+		else
+			bLevelFileOpen = ImportLevelInternal();
+		if (!bLevelFileOpen && Phase == EImportPhase::Level)
+			EnterPhase(EImportPhase::Materials);
+		break;
+	case EImportPhase::Materials:
+		if (ActiveMaterialParser.IsValid())
+		{
+			if (!ActiveMaterialParser->StepImportMaterial())
+				EndImportMaterialFile(PhaseQueue[PhaseIndex++]);
+		}
+		else if (PhaseIndex < PhaseQueue.Num())
+		{
+			PrefetchQueue();
+			if (bDryRun)
+				AnalyzeMaterialFile(PhaseQueue[PhaseIndex++]);
+			else if (!BeginImportMaterialFile(PhaseQueue[PhaseIndex]))
+				++PhaseIndex;
+		}
+		else
+		{
+			EnterPhase(EImportPhase::MaterialInstanceConstants);
+		}
+		break;
+	case EImportPhase::MaterialInstanceConstants:
+		if (PhaseIndex < PhaseQueue.Num())
+		{
+			PrefetchQueue();
+			if (bDryRun)
+				bPhaseImportedAssets |= AnalyzeMaterialInstanceConstantFile(PhaseQueue[PhaseIndex++]);
+			else
+				bPhaseImportedAssets |= ImportMaterialInstanceConstantFile(PhaseQueue[PhaseIndex++]);
+		}
+		else
+		{
+			// Imported instances may require parents that are instances too
+			EnterPhase(bPhaseImportedAssets ? EImportPhase::MaterialInstanceConstants : EImportPhase::ResolveLinks);
+		}
+		break;
+	case EImportPhase::ResolveLinks:
+		if (PhaseIndex < PhaseQueue.Num())
+			ResolveRequirement(PhaseQueue[PhaseIndex++].Requirement);
+		else
+			EnterPhase(EImportPhase::Finalize);
+		break;
+	case EImportPhase::Finalize:
+		if (FinalizeImport(FinalizeStep))
+		{
+			FinalizeStep = (EFinalizeStep::Type)(FinalizeStep + 1);
+			bFinalizeStepStarted = false;
+			PhaseQueue.Reset();
+			PhaseIndex = 0;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+float T3DLevelParser::GetImportProgress() const
+{
+	// File phases take most of the time, linking and compiling share the rest
+	switch (Phase)
+	{
+	case EImportPhase::Level:
+		return 0.f;
+	case EImportPhase::Materials:
+	case EImportPhase::MaterialInstanceConstants:
+		return TotalBytes > 0 ? 0.8f * ProcessedBytes / TotalBytes : 0.f;
+	case EImportPhase::ResolveLinks:
+		return 0.8f + (PhaseQueue.Num() > 0 ? 0.05f * PhaseIndex / PhaseQueue.Num() : 0.f);
+	case EImportPhase::Finalize:
+	{
+		float StepProgress = FinalizeStep;
+		if (FinalizeStep == EFinalizeStep::SavePackages && PackagesToSave.Num() > 0)
+			StepProgress += (float)SaveIndex / PackagesToSave.Num();
+		else if (PhaseQueue.Num() > 0)
+			StepProgress += (float)PhaseIndex / PhaseQueue.Num();
+		return 0.85f + 0.15f * StepProgress / (EFinalizeStep::Report + 1);
+	}
+	default:
+		return 1.f;
+	}
+}
+
+FText T3DLevelParser::GetImportStatus() const
+{
+	switch (Phase)
+	{
+	case EImportPhase::Level:
+		return LOCTEXT("ParsingUDKLevelT3D", "Parsing UDK Level informations");
+	case EImportPhase::Materials:
+	case EImportPhase::MaterialInstanceConstants:
+	{
+		FFormatNamedArguments Args;
+		Args.Add(TEXT("File"), FText::FromString(FPaths::GetBaseFilename(CurrentFile)));
+		Args.Add(TEXT("Processed"), FText::AsMemory(ProcessedBytes));
+		Args.Add(TEXT("Total"), FText::AsMemory(TotalBytes));
+		const double Elapsed = FPlatformTime::Seconds() - FilePhaseStartTime;
+		if (ProcessedBytes == 0 || Elapsed <= 0.)
+		{
+			return Phase == EImportPhase::Materials
+				? FText::Format(LOCTEXT("ExportMaterialAssets", "Parsing material {File} ({Processed} of {Total})"), Args)
+				: FText::Format(LOCTEXT("ExportMaterialInstanceConstantAssets", "Parsing material instance {File} ({Processed} of {Total})"), Args);
+		}
+		const double Remaining = (TotalBytes - ProcessedBytes) * Elapsed / ProcessedBytes;
+		Args.Add(TEXT("Remaining"), FText::AsTimespan(FTimespan::FromSeconds(FMath::CeilToDouble(Remaining))));
+		return Phase == EImportPhase::Materials
+			? FText::Format(LOCTEXT("ExportMaterialAssetsETA", "Parsing material {File} ({Processed} of {Total}, {Remaining} left)"), Args)
+			: FText::Format(LOCTEXT("ExportMaterialInstanceConstantAssetsETA", "Parsing material instance {File} ({Processed} of {Total}, {Remaining} left)"), Args);
+	}
+	case EImportPhase::ResolveLinks:
+		return LOCTEXT("ResolvingLinks", "Fixing reference with existing assets");
+	case EImportPhase::Finalize:
+		switch (FinalizeStep)
+		{
+		case EFinalizeStep::PrepareAssets: return LOCTEXT("EnforceSamplerBudget", "Rebuilding textures and checking sampler budgets");
+		case EFinalizeStep::CompileMaterials: return FText::Format(LOCTEXT("CompilingMaterials", "Compiling materials ({0} of {1})"), FText::AsNumber(PhaseIndex), FText::AsNumber(PhaseQueue.Num()));
+		case EFinalizeStep::CompileStaticPermutations: return LOCTEXT("CompilingStaticPermutations", "Compiling static permutations");
+		case EFinalizeStep::WaitForShaders: return FText::Format(LOCTEXT("WaitingForShaders", "Waiting for shaders ({0} left)"), FText::AsNumber(GShaderCompilingManager->GetNumRemainingJobs()));
+		case EFinalizeStep::CompileMaterialInstances: return FText::Format(LOCTEXT("CompilingMaterialInstances", "Compiling material instances ({0} of {1})"), FText::AsNumber(PhaseIndex), FText::AsNumber(PhaseQueue.Num()));
+		case EFinalizeStep::BuildStaticMeshes: return LOCTEXT("BuildingStaticMeshes", "Building static meshes");
+		case EFinalizeStep::ReportMaterialCosts: return FText::Format(LOCTEXT("ReportMaterialCosts", "Gathering material costs ({0} of {1})"), FText::AsNumber(PhaseIndex), FText::AsNumber(PhaseQueue.Num()));
+		case EFinalizeStep::SavePackages: return FText::Format(LOCTEXT("SavingPackages", "Saving packages ({0} of {1})"), FText::AsNumber(SaveIndex), FText::AsNumber(PackagesToSave.Num()));
+		default: return LOCTEXT("ReportMissing", "Reporting missing assets");
+		}
+	case EImportPhase::Cancelled:
+		return LOCTEXT("ImportCancelled", "Import cancelled");
+	default:
+		return LOCTEXT("ImportDone", "Import done");
+	}
+}
+
+const TCHAR * T3DLevelParser::PhaseName(EImportPhase::Type ImportPhase)
+{
+	switch (ImportPhase)
+	{
+	case EImportPhase::Level: return TEXT("Level");
+	case EImportPhase::Materials: return TEXT("Materials");
+	case EImportPhase::MaterialInstanceConstants: return TEXT("MaterialInstanceConstants");
+	case EImportPhase::ResolveLinks: return TEXT("ResolveLinks");
+	case EImportPhase::Finalize: return TEXT("Finalize");
+	case EImportPhase::Done: return TEXT("Done");
+	default: return TEXT("Cancelled");
+	}
+}
+
+void T3DLevelParser::SnapshotMemory()
+{
+	FMemorySnapshot &Snapshot = MemorySnapshots[MemorySnapshots.AddDefaulted()];
+	const FPlatformMemoryStats Stats = FPlatformMemory::GetStats();
+	Snapshot.Phase = PhaseName(Phase);
+	Snapshot.UsedPhysical = Stats.UsedPhysical;
+	Snapshot.PhasePeakUsedPhysical = FMath::Max<uint64>(PhasePeakUsedPhysical, Stats.UsedPhysical);
+	Snapshot.PeakUsedPhysical = Stats.PeakUsedPhysical;
+
+	// Parser buffers : lines of the level file, files read ahead
+	Snapshot.ParserBytes = Lines.GetAllocatedSize();
+	for (const FString &String : Lines)
+	{
+		Snapshot.ParserBytes += String.GetAllocatedSize();
+	}
+	Snapshot.PrefetchedFiles = PrefetchedFiles.Num();
+
+	// Requirement maps, with the delegates waiting on them
+	Snapshot.RequirementBytes = Requirements.GetAllocatedSize() + FixedRequirements.GetAllocatedSize() + PhaseQueue.GetAllocatedSize();
+	Snapshot.PendingDelegates = 0;
+	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		Snapshot.RequirementBytes += Iter.Key().Url.GetAllocatedSize() + Iter.Key().OriginalUrl.GetAllocatedSize() + Iter.Value().GetAllocatedSize();
+		Snapshot.PendingDelegates += Iter.Value().Num();
+	}
+	for (auto Iter = FixedRequirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		Snapshot.RequirementBytes += Iter.Key().Url.GetAllocatedSize() + Iter.Key().OriginalUrl.GetAllocatedSize();
+	}
+
+	Snapshot.CacheBytes = SourceClasses.GetAllocatedSize() + ParameterIndices.GetAllocatedSize() + PendingStaticPermutations.GetAllocatedSize() + Substitutions.GetAllocatedSize() + TouchedPackages.GetAllocatedSize();
+
+	// Objects created by this import, pinned until saved
+	Snapshot.CreatedObjects = 0;
+	Snapshot.CreatedObjectBytes = 0;
+	for (const TWeakObjectPtr<UObject> &Asset : CreatedAssets)
+	{
+		if (Asset.IsValid())
+		{
+			++Snapshot.CreatedObjects;
+			Snapshot.CreatedObjectBytes += Asset->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+	}
+
+	SET_MEMORY_STAT(STAT_UDKImport_ParserMemory, Snapshot.ParserBytes);
+	SET_MEMORY_STAT(STAT_UDKImport_RequirementMemory, Snapshot.RequirementBytes);
+	SET_MEMORY_STAT(STAT_UDKImport_CacheMemory, Snapshot.CacheBytes);
+	SET_DWORD_STAT(STAT_UDKImport_PendingDelegates, Snapshot.PendingDelegates);
+	SET_DWORD_STAT(STAT_UDKImport_CreatedObjects, Snapshot.CreatedObjects);
+}
+
+uint64 T3DLevelParser::GetPeakUsedPhysical() const
+{
+	uint64 Peak = PhasePeakUsedPhysical;
+	for (const FMemorySnapshot &Snapshot : MemorySnapshots)
+	{
+		Peak = FMath::Max(Peak, Snapshot.PhasePeakUsedPhysical);
+	}
+	return Peak;
+}
+
+void T3DLevelParser::ReportMemory() const
+{
+	FString Report = TEXT("Phase,UsedMB,PhasePeakMB,ProcessPeakMB,ParserKB,PrefetchedFiles,RequirementKB,PendingDelegates,CacheKB,CreatedObjects,CreatedObjectKB\n");
+	for (const FMemorySnapshot &Snapshot : MemorySnapshots)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("%-26s used %5llu MB, phase peak %5llu MB, process peak %5llu MB | parser %lld KB (%d read ahead), requirements %lld KB (%d delegates), caches %lld KB, %d created objects %lld KB"),
+			*Snapshot.Phase, Snapshot.UsedPhysical / 1024 / 1024, Snapshot.PhasePeakUsedPhysical / 1024 / 1024, Snapshot.PeakUsedPhysical / 1024 / 1024,
+			Snapshot.ParserBytes / 1024, Snapshot.PrefetchedFiles, Snapshot.RequirementBytes / 1024, Snapshot.PendingDelegates, Snapshot.CacheBytes / 1024, Snapshot.CreatedObjects, Snapshot.CreatedObjectBytes / 1024);
+		Report += FString::Printf(TEXT("%s,%llu,%llu,%llu,%lld,%d,%lld,%d,%lld,%d,%lld\n"),
+			*Snapshot.Phase, Snapshot.UsedPhysical / 1024 / 1024, Snapshot.PhasePeakUsedPhysical / 1024 / 1024, Snapshot.PeakUsedPhysical / 1024 / 1024,
+			Snapshot.ParserBytes / 1024, Snapshot.PrefetchedFiles, Snapshot.RequirementBytes / 1024, Snapshot.PendingDelegates, Snapshot.CacheBytes / 1024, Snapshot.CreatedObjects, Snapshot.CreatedObjectBytes / 1024);
+	}
+
+	FString ReportPath = ReportDirectory / TEXT("Memory.csv");
+	if (!FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to write memory report : %s"), *ReportPath);
+	}
+}
+
+void T3DLevelParser::PrefetchFile(const FString &FileName)
+{
+	if (PrefetchedFiles.Contains(FileName))
+		return;
+
+	PrefetchedFiles.Add(FileName, Async(EAsyncExecution::ThreadPool, [FileName]()
+	{
+		UDKIMPORT_LLM_SCOPE(Parser);
+		FT3DFilePtr File = MakeShared<FT3DFile, ESPMode::ThreadSafe>();
+		FString Content;
+		File->bLoaded = FFileHelper::LoadFileToString(Content, *FileName);
+		File->Bytes = File->bLoaded ? IFileManager::Get().FileSize(*FileName) : 0;
+		Content.ParseIntoArray(File->Lines, TEXT("\n"), true);
+		return File;
+	}));
+}
+
+void T3DLevelParser::PrefetchQueue()
+{
+	const int32 Last = FMath::Min(PhaseQueue.Num(), PhaseIndex + Settings.PrefetchFiles);
+	for (int32 Index = PhaseIndex; Index < Last; ++Index)
+	{
+		PrefetchFile(PhaseQueue[Index].FileName);
+	}
+}
+
+bool T3DLevelParser::LoadFile(const FString &FileName, TArray<FString> &OutLines)
+{
+	UDKIMPORT_LLM_SCOPE(Parser);
+	PrefetchFile(FileName);
+	FT3DFilePtr File = PrefetchedFiles[FileName].Get();
+	PrefetchedFiles.Remove(FileName);
+
+	CurrentFile = FileName;
+	if (!File->bLoaded)
+	{
+		ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::UnreadableFile, FileName, 0, FString(), TEXT("Unable to read file"));
+		return false;
+	}
+
+	Counters.Files++;
+	Counters.Bytes += File->Bytes;
+	Counters.Lines += File->Lines.Num();
+	OutLines = MoveTemp(File->Lines);
+	return true;
+}
+
+void T3DLevelParser::ModifyObject(UObject * Object)
+{
+	TouchedPackages.Add(Object->GetOutermost());
+	if (Settings.bBulkImport)
+		Object->MarkPackageDirty();
+	else
+		Object->Modify();
+}
+
+void T3DLevelParser::EndBulkImport()
+{
+	// Undo history may still point at objects this import replaced. Only a commandlet owns the whole
+	// history, in the editor it holds unrelated work of the user and is left alone
+	if (IsRunningCommandlet() && GEditor && GEditor->Trans)
+	{
+		GEditor->Trans->Reset(LOCTEXT("BulkImportDone", "UDK bulk import"));
+	}
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+UObject * T3DLevelParser::CreateAsset(const FString &Name, const FString &PackagePath, UClass * Class, UFactory * Factory)
+{
+	UDKIMPORT_LLM_SCOPE(Assets);
+	// What AssetTools::CreateAsset does, minus the per asset editor notifications
+	const FString PackageName = PackagePath / Name;
+	const FString ObjectPath = PackageName + TEXT(".") + Name;
+	// Callers only create an asset once loading it as Class failed, whatever already uses the path is something else
+	UObject * Existing = StaticFindObject(UObject::StaticClass(), NULL, *ObjectPath);
+	if (Existing != NULL || FPackageName::DoesPackageExist(PackageName))
+	{
+		const FString ExistingClass = Existing != NULL ? Existing->GetClass()->GetName() : TEXT("another asset");
+		ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::ImportFailed, FString(), 0, ObjectPath, FString::Printf(TEXT("%s is already used by %s, the imported %s is not created"), *ObjectPath, *ExistingClass, *Class->GetName()));
+		return NULL;
+	}
+	UPackage * Package = CreatePackage(*PackageName);
+	UObject * Asset = Factory->FactoryCreateNew(Class, Package, FName(*Name), RF_Public | RF_Standalone | RF_Transactional, NULL, GWarn);
+	if (Asset == NULL)
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to create %s %s"), *Class->GetName(), *PackageName);
+		return NULL;
+	}
+
+	Asset->MarkPackageDirty();
+	TrackAsset(Asset, true);
+	PendingRegistryNotifications.Add(Asset);
+	return Asset;
+}
+
+void T3DLevelParser::NotifyCreatedAssets()
+{
+	// Created assets are announced once the file phases are over, content browser updates included
+	for (const TWeakObjectPtr<UObject> &Asset : PendingRegistryNotifications)
+	{
+		if (Asset.IsValid())
+		{
+			FAssetRegistryModule::AssetCreated(Asset.Get());
+		}
+	}
+	UE_LOG(UDKImportPluginLog, Log, TEXT("%d assets created"), PendingRegistryNotifications.Num());
+	PendingRegistryNotifications.Empty();
+}
+
+void T3DLevelParser::TrackAsset(UObject * Asset, bool bCreated)
+{
+	TouchedPackages.Add(Asset->GetOutermost());
+	if (bCreated)
+		CreatedAssets.Add(Asset);
+	else
+		OverwrittenPackages.AddUnique(Asset->GetOutermost());
+}
+
+void T3DLevelParser::TrackModifiedAsset(UObject * Asset)
+{
+	if (!CreatedAssets.Contains(Asset))
+		TrackAsset(Asset, false);
+}
+
+bool T3DLevelParser::IsImportedAsset(UObject * Asset) const
+{
+	return CreatedAssets.Contains(Asset) || OverwrittenPackages.Contains(Asset->GetOutermost());
+}
+
+void T3DLevelParser::RollbackImport()
+{
+	// Reads still in flight are simply dropped, so is the file being read
+	PrefetchedFiles.Empty();
+	ComponentReregisterContext.Reset();
+	ActiveMaterialParser.Reset();
+	bLevelFileOpen = false;
+
+	int32 DestroyedActors = 0;
+	for (const TWeakObjectPtr<AActor> &Actor : SpawnedActors)
+	{
+		if (Actor.IsValid() && Actor->GetWorld()->EditorDestroyActor(Actor.Get(), true))
+			++DestroyedActors;
+	}
+
+	TArray<UObject*> Created;
+	for (const TWeakObjectPtr<UObject> &Asset : CreatedAssets)
+	{
+		if (Asset.IsValid())
+			Created.Add(Asset.Get());
+	}
+	const int32 DeletedAssets = Created.Num() > 0 ? ObjectTools::DeleteObjectsUnchecked(Created) : 0;
+
+	// Overwritten assets go back to their saved state
+	TArray<UPackage*> Overwritten;
+	for (const TWeakObjectPtr<UPackage> &Package : OverwrittenPackages)
+	{
+		if (Package.IsValid())
+			Overwritten.Add(Package.Get());
+	}
+	FText ErrorMessage;
+	if (Overwritten.Num() > 0 && !UPackageTools::ReloadPackages(Overwritten, ErrorMessage, EReloadPackagesInteractionMode::AssumePositive))
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to restore overwritten assets : %s"), *ErrorMessage.ToString());
+	}
+
+	SpawnedActors.Empty();
+	CreatedAssets.Empty();
+	PendingRegistryNotifications.Empty();
+	OverwrittenPackages.Empty();
+	TouchedPackages.Empty();
+	Requirements.Empty();
+	FixedRequirements.Empty();
+	PendingStaticPermutations.Empty();
+	ParameterIndices.Empty();
+	AlphaSamplers.Empty();
+	PhaseQueue.Empty();
+	PackagesToSave.Empty();
+	MaterialCosts.Empty();
+	UniqueShaderMaps.Empty();
+	UE_LOG(UDKImportPluginLog, Log, TEXT("Import cancelled, %d actors destroyed, %d assets deleted, %d packages reloaded"), DestroyedActors, DeletedAssets, Overwritten.Num());
+}
+
+void T3DLevelParser::AddReferencedObjects(FReferenceCollector &Collector)
+{
+	Collector.AddReferencedObject(World);
+	for (auto Iter = FixedRequirements.CreateIterator(); Iter; ++Iter)
+	{
+		Collector.AddReferencedObject(Iter.Value());
+	}
+	for (auto Iter = Substitutions.CreateIterator(); Iter; ++Iter)
+	{
+		Collector.AddReferencedObject(Iter.Value());
+	}
+	for (auto Iter = PendingStaticPermutations.CreateIterator(); Iter; ++Iter)
+	{
+		UObject * MaterialInstanceConstant = Iter.Key();
+		Collector.AddReferencedObject(MaterialInstanceConstant);
+	}
+	Collector.AddReferencedObjects(PackagesToSave);
+}
+
+FString T3DLevelParser::RessourceTypeFor(EExportType::Type Type)
+{
+	switch (Type)
+	{
+	case EExportType::Material: return TEXT("Material");
+	case EExportType::StaticMesh: return TEXT("StaticMesh");
+	case EExportType::MaterialInstanceConstant: return TEXT("MaterialInstanceConstant");
+	case EExportType::Texture2D: return TEXT("Texture2D");
+	default: return TEXT("Unknow");
+	}
+}
+
+void T3DLevelParser::PreloadSubstitutions()
+{
+	for (auto Iter = Settings.FunctionSubstitutions.CreateConstIterator(); Iter; ++Iter)
+	{
+		if (!Substitutions.Contains(Iter.Key()) && !PendingSubstitutionLoads.Contains(Iter.Key()))
+		{
+			PendingSubstitutionLoads.Add(Iter.Key(), LoadPackageAsync(FPackageName::ObjectPathToPackageName(Iter.Value())));
+		}
+	}
+}
+
+UMaterialFunctionInterface * T3DLevelParser::GetSubstitution(const FString &ExpressionClass)
+{
+	UMaterialFunctionInterface ** pFunction = Substitutions.Find(ExpressionClass);
+	if (pFunction != NULL)
+		return *pFunction;
+
+	const FString * pFunctionPath = Settings.FunctionSubstitutions.Find(ExpressionClass);
+	if (pFunctionPath == NULL)
+		return NULL;
+
+	int32 RequestId;
+	if (PendingSubstitutionLoads.RemoveAndCopyValue(ExpressionClass, RequestId))
+	{
+		FlushAsyncLoading(RequestId);
+	}
+
+	UMaterialFunctionInterface * Function = FindObject<UMaterialFunctionInterface>(NULL, **pFunctionPath);
+	if (Function == NULL)
+	{
+		INC_DWORD_STAT(STAT_UDKImport_SyncLoads);
+		Function = LoadObject<UMaterialFunctionInterface>(NULL, **pFunctionPath);
+	}
+	if (Function == NULL)
+	{
+		ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::MissingFunction, FString(), 0, *pFunctionPath, FString::Printf(TEXT("Unable to load material function replacing %s"), *ExpressionClass));
+	}
+
+	// Cache failures too, a missing function is reported once
+	Substitutions.Add(ExpressionClass, Function);
+	return Function;
+}
+
+static FString SniffT3DClass(const FString &FileName)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FileName));
+	if (!Reader)
+		return FString();
+
+	// "Begin Object Class=... Name=..." fits in the first bytes, whatever the encoding
+	uint8 Header[512];
+	const int32 Size = (int32)FMath::Min<int64>(Reader->TotalSize(), sizeof(Header)) & ~1;
+	Reader->Serialize(Header, Size);
+
+	FString Content, FirstLine, Class;
+	FFileHelper::BufferToString(Content, Header, Size);
+	if (!Content.Split(TEXT("\n"), &FirstLine, NULL))
+		FirstLine = Content;
+	FParse::Value(*FirstLine, TEXT("Class="), Class);
+	return Class;
+}
+
+static FString RequirementTypeForClass(const FString &Class)
+{
+	// The material parser handles both
+	return Class == TEXT("DecalMaterial") ? FString(TEXT("Material")) : Class;
+}
+
+void T3DLevelParser::BuildSourceIndex()
+{
+	if (SourceClasses.Num() > 0)
+		return;
+
+	TArray<FString> FileNames;
+	if (ShardFiles.Num() > 0)
+		FileNames = ShardFiles.Array();
+	else
+		IFileManager::Get().FindFilesRecursive(FileNames, *SourcePath, _T("*.T3D"), true, false);
+
+	TArray<FString> Classes;
+	Classes.SetNum(FileNames.Num());
+	ParallelFor(FileNames.Num(), [&FileNames, &Classes](int32 Index)
+	{
+		Classes[Index] = SniffT3DClass(FileNames[Index]);
+	});
+
+	TMap<FString, int32> FilesByClass;
+	for (int32 Index = 0; Index < FileNames.Num(); ++Index)
+	{
+		SourceClasses.Add(FileNames[Index], Classes[Index]);
+		FilesByClass.FindOrAdd(Classes[Index].IsEmpty() ? TEXT("Unknown") : Classes[Index])++;
+	}
+	for (auto Iter = FilesByClass.CreateConstIterator(); Iter; ++Iter)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("%d %s files in %s"), Iter.Value(), *Iter.Key(), *SourcePath);
+	}
+}
+
+void T3DLevelParser::RetypeRequirementsFromSource()
+{
+	for (auto Iter = Requirements.CreateIterator(); Iter; ++Iter)
+	{
+		FRequirement &Requirement = Iter.Key();
+		const FString * Class = SourceClasses.Find(GetPathToT3D(Requirement.RelDirectory, Requirement.Name));
+		if (Class && Requirement.Type == TEXT("Material") && RequirementTypeForClass(*Class) == TEXT("MaterialInstanceConstant"))
+		{
+			// Level actors reference instances as materials, parse them with the right parser from the start
+			Requirement.Type = *Class;
+		}
+	}
+}
+
+void T3DLevelParser::ExportPackageToRequirements(EExportType::Type Type)
+{
+	FString RessourceType = RessourceTypeFor(Type);
+
+	int32 Skipped = 0;
+	for (auto Iter = SourceClasses.CreateConstIterator(); Iter; ++Iter)
+	{
+		const FString FileType = RequirementTypeForClass(Iter.Value());
+		// Importing materials has always brought their instances along
+		if (FileType != RessourceType && !(Type == EExportType::Material && FileType == TEXT("MaterialInstanceConstant")))
+		{
+			++Skipped;
+			continue;
+		}
+
+		FString relPath = Iter.Key();
+		relPath.RemoveFromEnd(".T3D", ESearchCase::IgnoreCase);
+		relPath.RemoveFromStart((SourcePath + "/"), ESearchCase::IgnoreCase);
+		relPath = relPath.Replace(_T("/"), _T("."));
+		AddRequirement(FString::Printf(TEXT("%s'%s'"), *FileType, *relPath), UObjectDelegate());
+	}
+	UE_LOG(UDKImportPluginLog, Log, TEXT("%d files are not %s, skipped"), Skipped, *RessourceType);
+}
+
+bool T3DLevelParser::BeginImportLevelFile()
+{
+	const FString FileName = SourcePath / TEXT("PersistentLevel.T3D");
+	TArray<FString> LevelLines;
+	SourceFile = FileName;
+	if (!LoadFile(FileName, LevelLines))
+	{
+		Phase = EImportPhase::Done;
+		return false;
+	}
+
+	ResetParser(MoveTemp(LevelLines));
+	RelDirectory = _T("");
+	ensure(NextLine());
+	ensure(Line.Equals(TEXT("Begin Object Class=Level Name=PersistentLevel")));
+	return true;
+}
+
+void T3DLevelParser::ResolveRequirement(const FRequirement &Requirement)
+{
+	UDKIMPORT_SCOPE(ResolveRequirements);
+	if (!Requirements.Contains(Requirement))
+		return;
+
+	FString ObjectPath = GetPathToUAsset(Requirement.RelDirectory, Requirement.Name);
+	UObject * asset = NULL;
+
+	if (bDryRun)
+	{
+		if (AssetExists(ObjectPath))
+		{
+			DryRun.ExistingReferences.FindOrAdd(Requirement.Type)++;
+			MarkResolved(Requirement);
+		}
+		return;
+	}
+
+	if (Requirement.Type == TEXT("StaticMesh"))
+	{
+		INC_DWORD_STAT(STAT_UDKImport_SyncLoads);
+		asset = LoadObject<UStaticMesh>(NULL, *ObjectPath);
+	}
+	else if (Requirement.Type == TEXT("Material") || Requirement.Type == TEXT("DecalMaterial") || Requirement.Type == TEXT("MaterialInstanceConstant"))
+	{
+		// Instances are referenced as materials too, and may come from another import
+		INC_DWORD_STAT(STAT_UDKImport_SyncLoads);
+		asset = LoadObject<UMaterialInterface>(NULL, *ObjectPath);
+	}
+	else if (Requirement.Type.StartsWith(TEXT("Texture")))
+	{
+		INC_DWORD_STAT(STAT_UDKImport_SyncLoads);
+		asset = LoadObject<UTexture>(NULL, *ObjectPath);
+	}
+
+	if (asset)
+	{
+		FixRequirement(Requirement, asset);
+	}
+}
+
+bool T3DLevelParser::FinalizeImport(EFinalizeStep::Type Step)
+{
+	// Nothing to compile or save in a dry run, only the reports are left
+	if (bDryRun && Step != EFinalizeStep::Report)
+		return true;
+
+	// Steps taking several calls set up their queue on the first one
+	const bool bStarting = !bFinalizeStepStarted;
+	bFinalizeStepStarted = true;
+
+	switch (Step)
+	{
+	case EFinalizeStep::PrepareAssets:
+		// Textures are bound now, samplers can be counted
+		ApplyTextureFixups();
+		if (Settings.bConvertBrushes)
+			ConvertBrushesToStaticMeshes();
+		if (Settings.bSetupHLOD)
+			SetupHierarchicalLOD();
+		EnforceSamplerBudget();
+		NotifyCreatedAssets();
+		CollectPackagesToSave();
+		break;
+	case EFinalizeStep::CompileMaterials:
+		if (bStarting)
+		{
+			// make sure that any static meshes, etc using this material will stop using the FMaterialResource of the original 
+			// material, and will use the new FMaterialResource created when we make a new UMaterial in place
+			ComponentReregisterContext = MakeShareable(new FGlobalComponentReregisterContext());
+			QueueFixedRequirements(TEXT("Material"));
+		}
+		return PostEditChangeNext();
+	case EFinalizeStep::CompileStaticPermutations:
+		if (Settings.bFlattenInstanceChains)
+			FlattenInstanceChains();
+		BindMaterialInstanceParameters();
+		ApplyStaticPermutations();
+		break;
+	case EFinalizeStep::WaitForShaders:
+		return WaitForShaderCompilation();
+	case EFinalizeStep::CompileMaterialInstances:
+	{
+		if (bStarting)
+			QueueFixedRequirements(TEXT("MaterialInstanceConstant"));
+		if (PhaseIndex < PhaseQueue.Num())
+		{
+			// The other instances of a static permutation find its shader map compiled
+			UMaterialInstanceConstant * MaterialInstanceConstant = Cast<UMaterialInstanceConstant>(FixedRequirements.FindRef(PhaseQueue[PhaseIndex].Requirement));
+			FStaticParameterSet StaticParameters;
+			if (MaterialInstanceConstant && PendingStaticPermutations.RemoveAndCopyValue(MaterialInstanceConstant, StaticParameters))
+				MaterialInstanceConstant->UpdateStaticPermutation(StaticParameters);
+		}
+		if (!PostEditChangeNext())
+			return false;
+
+		for (auto Iter = PendingStaticPermutations.CreateConstIterator(); Iter; ++Iter)
+		{
+			Iter.Key()->UpdateStaticPermutation(Iter.Value());
+		}
+		PendingStaticPermutations.Empty();
+		break;
+	}
+	case EFinalizeStep::BuildStaticMeshes:
+		// Slots assigned by SetStaticMeshMaterialResolved are built here, once per mesh
+		if (bStarting)
+			QueueFixedRequirements(TEXT("StaticMesh"));
+		if (!PostEditChangeNext())
+			return false;
+		ComponentReregisterContext.Reset();
+		break;
+	case EFinalizeStep::ReportMaterialCosts:
+		if (bStarting)
+		{
+			MaterialCosts.Reset();
+			UniqueShaderMaps.Reset();
+			QueueFixedRequirements(TEXT("Material"));
+			QueueFixedRequirements(TEXT("MaterialInstanceConstant"));
+		}
+		if (PhaseIndex < PhaseQueue.Num())
+		{
+			if (GatherMaterialCost(PhaseQueue[PhaseIndex].Requirement))
+				++PhaseIndex;
+			return false;
+		}
+		ReportMaterialCosts();
+		break;
+	case EFinalizeStep::SavePackages:
+		return !Settings.bSaveImportedPackages || SavePackageBatch();
+	case EFinalizeStep::Report:
+	{
+		SourceFile.Empty();
+		SnapshotMemory();
+		ReportMemory();
+		CollectIncompleteFiles();
+		ReportMissingRequirements();
+		if (bDryRun)
+			ReportDryRun();
+		if (ImportDiagnostics.Num() > 0)
+			ImportDiagnostics.Report(bDryRun ? LOCTEXT("DryRunDiagnostics", "UDK import dry run finished") : LOCTEXT("ImportDiagnostics", "UDK import finished with problems"));
+		const FString DiagnosticsPath = ReportDirectory / TEXT("Diagnostics.json");
+		if (!ImportDiagnostics.WriteJson(DiagnosticsPath))
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to write diagnostics : %s"), *DiagnosticsPath);
+		}
+		if (Settings.bBulkImport && !bDryRun)
+			EndBulkImport();
+		Phase = EImportPhase::Done;
+		break;
+	}
+	}
+	return true;
+}
+
+void T3DLevelParser::SetReportDirectory(const FString &Directory)
+{
+	ReportDirectory = Directory;
+}
+
+void T3DLevelParser::SetShardFiles(const TArray<FString> &Files)
+{
+	ShardFiles.Reset();
+	SourceClasses.Reset();
+	for (const FString &File : Files)
+	{
+		ShardFiles.Add(FPaths::IsRelative(File) ? SourcePath / File : File);
+	}
+}
+
+void T3DLevelParser::CollectIncompleteFiles()
+{
+	// Instances whose parent is still unknown, a later pass run once every parent is saved can link them
+	IncompleteFiles.Reset();
+	for (auto Iter = FixedRequirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		UMaterialInstanceConstant * MaterialInstanceConstant = Cast<UMaterialInstanceConstant>(Iter.Value());
+		if (MaterialInstanceConstant && MaterialInstanceConstant->Parent == NULL)
+		{
+			IncompleteFiles.Add(GetPathToT3D(Iter.Key().RelDirectory, Iter.Key().Name));
+		}
+	}
+}
+
+void T3DLevelParser::CollectPackagesToSave()
+{
+	PackagesToSave.Reset();
+	SaveIndex = 0;
+	for (const TWeakObjectPtr<UPackage> &Package : TouchedPackages)
+	{
+		// Maps are saved by the owner of the world
+		if (Package.IsValid() && Package->IsDirty() && Package.Get() != GetTransientPackage() && UWorld::FindWorldInPackage(Package.Get()) == NULL)
+		{
+			PackagesToSave.Add(Package.Get());
+		}
+	}
+}
+
+bool T3DLevelParser::SavePackageBatch()
+{
+	static const int32 SaveBatchSize = 64;
+	const int32 First = SaveIndex;
+	const int32 Count = FMath::Min(SaveBatchSize, PackagesToSave.Num() - First);
+
+	// Packages are serialized on the game thread, their files are written by the async writer
+	TArray<FString> FileNames;
+	TArray<bool> Saved;
+	FileNames.SetNum(Count);
+	Saved.SetNumZeroed(Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		UPackage * Package = PackagesToSave[First + Index];
+		FileNames[Index] = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+		UObject * Asset = FindObjectFast<UObject>(Package, *FPackageName::GetShortName(Package));
+		Saved[Index] = UPackage::SavePackage(Package, Asset, RF_Standalone, *FileNames[Index], GLog, NULL, false, true, SAVE_NoError | SAVE_Async);
+	}
+	UPackage::WaitForAsyncFileWrites();
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		UPackage * Package = PackagesToSave[First + Index];
+		if (Saved[Index])
+		{
+			++SavedPackages;
+		}
+		else
+		{
+			SaveFailures.Add(Package->GetName());
+			ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::SaveFailed, FileNames[Index], 0, Package->GetName(), TEXT("Unable to save package"));
+		}
+	}
+
+	SaveIndex += Count;
+	if (SaveIndex < PackagesToSave.Num())
+		return false;
+
+	UE_LOG(UDKImportPluginLog, Log, TEXT("Saved %d packages, %d failed"), SavedPackages, SaveFailures.Num());
+	return true;
+}
+
+void T3DLevelParser::QueueFixedRequirements(const FString &Type, const TSet<UObject*> &Skip)
+{
+	for (auto Iter = FixedRequirements.CreateIterator(); Iter; ++Iter)
+	{
+		const FRequirement &Requirement = Iter.Key();
+		if (Requirement.Type == Type)
+		{
+			if (Requirement.Name == TEXT("MI_StargateSupport_Base"))
+			{
+				UE_LOG(UDKImportPluginLog, Warning, TEXT("Test Me : %s"), *Requirement.Url);
+			}
+			UObject * Object = Iter.Value();
+			if (Object && !Skip.Contains(Object))
+			{
+				FQueuedRequirement &Queued = PhaseQueue[PhaseQueue.AddDefaulted()];
+				Queued.Requirement = Requirement;
+				Queued.Bytes = 0;
+			}
+		}
+	}
+}
+
+bool T3DLevelParser::PostEditChangeNext()
+{
+	UDKIMPORT_SCOPE(PostEditChangeNext);
+	if (PhaseIndex < PhaseQueue.Num())
+	{
+		UObject * Object = FixedRequirements.FindRef(PhaseQueue[PhaseIndex++].Requirement);
+		if (Object)
+		{
+			Object->PostEditChange();
+		}
+	}
+	return PhaseIndex >= PhaseQueue.Num();
+}
+
+bool T3DLevelParser::WaitForShaderCompilation()
+{
+	// The editor tick processes finished jobs too, but the commandlet and the blocking imports have none
+	GShaderCompilingManager->ProcessAsyncResults(true, false);
+	return !GShaderCompilingManager->IsCompiling();
+}
+
+void T3DLevelParser::ApplyTextureFixups()
+{
+	UDKIMPORT_SCOPE(ApplyTextureFixups);
+	TSet<UTexture*> Textures;
+	for (const TWeakObjectPtr<UMaterialExpressionTextureBase> &Sampler : AlphaSamplers)
+	{
+		if (Sampler.IsValid() && Sampler->Texture && (Sampler->Texture->CompressionSettings == TC_Normalmap || Textures.Contains(Sampler->Texture)))
+		{
+			ModifyObject(Sampler.Get());
+			Sampler->SamplerType = SAMPLERTYPE_LinearColor;
+			Textures.Add(Sampler->Texture);
+		}
+	}
+	AlphaSamplers.Empty();
+	if (Textures.Num() == 0)
+		return;
+
+	// Other samplers of the rebuilt textures must match their new compression too
+	int32 Samplers = 0;
+	for (auto Iter = FixedRequirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		UMaterial * Material = Cast<UMaterial>(Iter.Value());
+		if (Material == NULL)
+			continue;
+
+		for (UMaterialExpression * Expression : Material->Expressions)
+		{
+			UMaterialExpressionTextureBase * Sampler = Cast<UMaterialExpressionTextureBase>(Expression);
+			if (Sampler && Sampler->SamplerType != SAMPLERTYPE_LinearColor && Textures.Contains(Sampler->Texture))
+			{
+				ModifyObject(Sampler);
+				Sampler->SamplerType = SAMPLERTYPE_LinearColor;
+				++Samplers;
+			}
+		}
+	}
+
+	// Compression of every texture runs on worker threads, then the resources are updated in one go
+	for (UTexture * Texture : Textures)
+	{
+		TrackModifiedAsset(Texture);
+		ModifyObject(Texture);
+		Texture->CompressionSettings = TC_Default;
+		Texture->BeginCachePlatformData();
+	}
+	for (UTexture * Texture : Textures)
+	{
+		Texture->FinishCachePlatformData();
+		Texture->PostEditChange();
+	}
+	UE_LOG(UDKImportPluginLog, Log, TEXT("%d normal maps rebuilt with their alpha channel, %d other samplers switched to linear color"), Textures.Num(), Samplers);
+}
+
+void T3DLevelParser::EnforceSamplerBudget()
+{
+	// Materials of the project the import only links to are left as they are
+	for (auto Iter = FixedRequirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		UMaterial * Material = Cast<UMaterial>(Iter.Value());
+		if (Material && IsImportedAsset(Material))
+		{
+			EnforceSamplerBudget(Material);
+		}
+	}
+}
+
+void T3DLevelParser::EnforceSamplerBudget(UMaterial * Material)
+{
+	// Samples of the same texture or texture parameter share one sampler
+	TSet<FString> Samplers;
+	TArray<TPair<UMaterialExpressionTextureSample*, FString> > Samples;
+	for (UMaterialExpression * Expression : Material->Expressions)
+	{
+		UMaterialExpressionTextureSample * Sample = Cast<UMaterialExpressionTextureSample>(Expression);
+		if (Sample && Sample->Texture && Sample->SamplerSource == SSM_FromTextureAsset)
+		{
+			UMaterialExpressionTextureSampleParameter * Parameter = Cast<UMaterialExpressionTextureSampleParameter>(Sample);
+			const FString Sampler = Parameter ? Parameter->ParameterName.ToString() : Sample->Texture->GetPathName();
+			Samplers.Add(Sampler);
+			Samples.Emplace(Sample, Sampler);
+		}
+	}
+
+	if (Samplers.Num() <= Settings.MaxMaterialSamplers)
+		return;
+
+	TrackModifiedAsset(Material);
+	ModifyObject(Material);
+	bool bUsesWrap = false, bUsesClamp = false;
+	TSet<FString> Dedicated;
+	for (const TPair<UMaterialExpressionTextureSample*, FString> &Entry : Samples)
+	{
+		UMaterialExpressionTextureSample * Sample = Entry.Key;
+		UTexture2D * Texture2D = Cast<UTexture2D>(Sample->Texture);
+		if (Texture2D && Texture2D->AddressX == TA_Clamp && Texture2D->AddressY == TA_Clamp)
+		{
+			ModifyObject(Sample);
+			Sample->SamplerSource = SSM_Clamp_WorldGroupSettings;
+			bUsesClamp = true;
+		}
+		else if (Texture2D == NULL || (Texture2D->AddressX == TA_Wrap && Texture2D->AddressY == TA_Wrap))
+		{
+			ModifyObject(Sample);
+			Sample->SamplerSource = SSM_Wrap_WorldGroupSettings;
+			bUsesWrap = true;
+		}
+		else
+		{
+			// Mirrored or mixed addressing has no shared equivalent, samples of the same texture still share theirs
+			Dedicated.Add(Entry.Value);
+		}
+	}
+
+	int32 SamplerCount = Dedicated.Num() + (bUsesWrap ? 1 : 0) + (bUsesClamp ? 1 : 0);
+	UE_LOG(UDKImportPluginLog, Log, TEXT("%s samples %d textures, moved to shared samplers (%d samplers left)"), *Material->GetPathName(), Samplers.Num(), SamplerCount);
+	if (SamplerCount > Settings.MaxMaterialSamplers)
+	{
+		ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Warning, FUDKImportDiagnostics::ECode::SamplerBudget, FString(), 0, Material->GetPathName(), FString::Printf(TEXT("Still uses %d samplers after switching to shared samplers, you will have to fix it manually"), SamplerCount));
+	}
+}
+
+FString T3DLevelParser::StaticPermutationKey(const FStaticParameterSet &StaticParameters)
+{
+	TArray<FString> Overrides;
+	for (const FStaticSwitchParameter &Parameter : StaticParameters.StaticSwitchParameters)
+	{
+		if (Parameter.bOverride)
+			Overrides.Add(FString::Printf(TEXT("%s=%d"), *Parameter.ParameterInfo.Name.ToString(), Parameter.Value ? 1 : 0));
+	}
+	for (const FStaticComponentMaskParameter &Parameter : StaticParameters.StaticComponentMaskParameters)
+	{
+		if (Parameter.bOverride)
+			Overrides.Add(FString::Printf(TEXT("%s=%d%d%d%d"), *Parameter.ParameterInfo.Name.ToString(), Parameter.R, Parameter.G, Parameter.B, Parameter.A));
+	}
+	Overrides.Sort();
+	return FString::Join(Overrides, TEXT(" "));
+}
+
+void T3DLevelParser::ApplyStaticPermutations()
+{
+	// Instances sharing a parent and the same overrides end up with the same shader map
+	TMap<FString, TArray<UMaterialInstanceConstant*> > Groups;
+	TArray<UMaterialInstanceConstant*> Orphans;
+	for (auto Iter = PendingStaticPermutations.CreateConstIterator(); Iter; ++Iter)
+	{
+		UMaterialInstanceConstant * MaterialInstanceConstant = Iter.Key();
+		if (MaterialInstanceConstant->Parent == NULL)
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Static parameters of %s dropped, its parent is missing"), *MaterialInstanceConstant->GetPathName());
+			Orphans.Add(MaterialInstanceConstant);
+			continue;
+		}
+		FString Key = MaterialInstanceConstant->Parent->GetPathName() + TEXT("|") + StaticPermutationKey(Iter.Value());
+		Groups.FindOrAdd(Key).Add(MaterialInstanceConstant);
+	}
+	for (UMaterialInstanceConstant * MaterialInstanceConstant : Orphans)
+	{
+		PendingStaticPermutations.Remove(MaterialInstanceConstant);
+	}
+
+	UE_LOG(UDKImportPluginLog, Log, TEXT("Applying static parameters to %d instances, %d permutations"), PendingStaticPermutations.Num(), Groups.Num());
+
+	// Compile the first instance of every group, in parallel. The remaining instances wait for their shader map
+	// in EFinalizeStep::WaitForShaders, then get their static parameters with the other instances
+	FMaterialUpdateContext UpdateContext;
+	for (auto Iter = Groups.CreateConstIterator(); Iter; ++Iter)
+	{
+		UMaterialInstanceConstant * MaterialInstanceConstant = Iter.Value()[0];
+		MaterialInstanceConstant->UpdateStaticPermutation(PendingStaticPermutations.FindAndRemoveChecked(MaterialInstanceConstant), &UpdateContext);
+	}
 }
 
-void T3DLevelParser::ImportLevel()
+const T3DLevelParser::FParameterIndex & T3DLevelParser::GetParameterIndex(UMaterial * Material)
 {
-	GWarn->BeginSlowTask(LOCTEXT("StatusBeginLevel", "Importing requested level"), true, false);
-	StatusNumerator = 0;
-	StatusDenominator = 12;
+	FParameterIndex * pIndex = ParameterIndices.Find(Material);
+	if (pIndex != NULL)
+		return *pIndex;
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("LoadUDKLevelT3D", "Loading UDK Level informations"));
+	FParameterIndex &Index = ParameterIndices.Add(Material);
+	for (UMaterialExpression * Expression : Material->Expressions)
 	{
-		FString UdkLevelT3D;
-		if (!FFileHelper::LoadFileToString(UdkLevelT3D, *(SourcePath / TEXT("PersistentLevel.T3D"))))
+		FParameterEntry Entry;
+		Entry.ExpressionGUID = Expression->GetParameterExpressionId();
+
+		FName ParameterName;
+		if (UMaterialExpressionScalarParameter * Scalar = Cast<UMaterialExpressionScalarParameter>(Expression))
+		{
+			ParameterName = Scalar->ParameterName;
+			Entry.Type = EParameterType::Scalar;
+		}
+		else if (UMaterialExpressionVectorParameter * Vector = Cast<UMaterialExpressionVectorParameter>(Expression))
+		{
+			ParameterName = Vector->ParameterName;
+			Entry.Type = EParameterType::Vector;
+		}
+		else if (UMaterialExpressionTextureSampleParameter * Texture = Cast<UMaterialExpressionTextureSampleParameter>(Expression))
+		{
+			ParameterName = Texture->ParameterName;
+			Entry.Type = EParameterType::Texture;
+		}
+		else if (UMaterialExpressionStaticBoolParameter * Switch = Cast<UMaterialExpressionStaticBoolParameter>(Expression))
+		{
+			ParameterName = Switch->ParameterName;
+			Entry.Type = EParameterType::StaticSwitch;
+		}
+		else if (UMaterialExpressionStaticComponentMaskParameter * Mask = Cast<UMaterialExpressionStaticComponentMaskParameter>(Expression))
 		{
-			GWarn->EndSlowTask();
-			return;
+			ParameterName = Mask->ParameterName;
+			Entry.Type = EParameterType::StaticComponentMask;
 		}
 
-		ResetParser(UdkLevelT3D);
-		RelDirectory = _T("");
+		if (!ParameterName.IsNone())
+		{
+			Index.Add(ParameterName, Entry);
+		}
 	}
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ParsingUDKLevelT3D", "Parsing UDK Level informations"));
-	ImportLevelInternal();
-
-	ResolveRequirements();
-	GWarn->EndSlowTask();
+	return Index;
 }
 
-void T3DLevelParser::ImportStaticMesh()
+template<typename ParameterType>
+static void MergeInheritedParameters(TArray<ParameterType> &Parameters, const TArray<ParameterType> &Inherited)
 {
-	ImportRessource(EExportType::StaticMesh);
+	for (const ParameterType &Parameter : Inherited)
+	{
+		if (!Parameters.ContainsByPredicate([&Parameter](const ParameterType &Existing) { return Existing.ParameterInfo == Parameter.ParameterInfo; }))
+			Parameters.Add(Parameter);
+	}
 }
 
-void T3DLevelParser::ImportMaterial()
+template<typename ParameterType>
+static void MergeInheritedStaticParameters(TArray<ParameterType> &Parameters, const TArray<ParameterType> &Inherited)
 {
-	ImportRessource(EExportType::Material);
+	for (const ParameterType &Parameter : Inherited)
+	{
+		if (Parameter.bOverride && !Parameters.ContainsByPredicate([&Parameter](const ParameterType &Existing) { return Existing.ParameterInfo == Parameter.ParameterInfo; }))
+			Parameters.Add(Parameter);
+	}
 }
 
-void T3DLevelParser::ImportMaterialInstanceConstant()
+void T3DLevelParser::FlattenInstanceChains()
 {
-	ImportRessource(EExportType::MaterialInstanceConstant);
+	// Instances of the project the import only links to keep their chain
+	int32 Flattened = 0;
+	for (auto Iter = FixedRequirements.CreateConstIterator(); Iter; ++Iter)
+	{
+		UMaterialInstanceConstant * MaterialInstanceConstant = Cast<UMaterialInstanceConstant>(Iter.Value());
+		if (MaterialInstanceConstant && IsImportedAsset(MaterialInstanceConstant) && FlattenInstanceChain(MaterialInstanceConstant))
+			++Flattened;
+	}
+	UE_LOG(UDKImportPluginLog, Log, TEXT("%d instance chains flattened onto their material"), Flattened);
 }
 
-void T3DLevelParser::ImportRessource(EExportType::Type Type)
+bool T3DLevelParser::FlattenInstanceChain(UMaterialInstanceConstant * MaterialInstanceConstant)
 {
-	StatusNumerator = 0;
-	StatusDenominator = 8;
+	UMaterialInstance * Ancestor = Cast<UMaterialInstance>(MaterialInstanceConstant->Parent);
+	if (Ancestor == NULL)
+		return false;
 
-	GWarn->BeginSlowTask(LOCTEXT("StatusBeginMaterialRessouces", "Scanning files"), true, false);
-	ExportPackageToRequirements(Type);
+	FStaticParameterSet StaticParameters;
+	const FStaticParameterSet * pStaticParameters = PendingStaticPermutations.Find(MaterialInstanceConstant);
+	if (pStaticParameters != NULL)
+	{
+		StaticParameters = *pStaticParameters;
+	}
 
-	ResolveRequirements();
-	GWarn->EndSlowTask();
+	// Walk up from the closest parent, a parameter already set by a closer instance is kept
+	TSet<UMaterialInstance*> Visited;
+	Visited.Add(MaterialInstanceConstant);
+	UMaterialInterface * Material = Ancestor;
+	for (; Ancestor != NULL; Ancestor = Cast<UMaterialInstance>(Ancestor->Parent))
+	{
+		if (Visited.Contains(Ancestor))
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Instance chain of %s loops, left as is"), *MaterialInstanceConstant->GetPathName());
+			return false;
+		}
+		Visited.Add(Ancestor);
+		Material = Ancestor->Parent;
+	}
+	if (Material == NULL)
+		return false;
+
+	ModifyObject(MaterialInstanceConstant);
+	for (Ancestor = Cast<UMaterialInstance>(MaterialInstanceConstant->Parent); Ancestor != NULL; Ancestor = Cast<UMaterialInstance>(Ancestor->Parent))
+	{
+		MergeInheritedParameters(MaterialInstanceConstant->ScalarParameterValues, Ancestor->ScalarParameterValues);
+		MergeInheritedParameters(MaterialInstanceConstant->VectorParameterValues, Ancestor->VectorParameterValues);
+		MergeInheritedParameters(MaterialInstanceConstant->TextureParameterValues, Ancestor->TextureParameterValues);
+
+		// Imported parents have not applied their static parameters yet
+		FStaticParameterSet AncestorStaticParameters;
+		UMaterialInstanceConstant * ImportedAncestor = Cast<UMaterialInstanceConstant>(Ancestor);
+		if (ImportedAncestor && PendingStaticPermutations.Contains(ImportedAncestor))
+			AncestorStaticParameters = PendingStaticPermutations[ImportedAncestor];
+		else
+			Ancestor->GetStaticParameterValues(AncestorStaticParameters);
+		MergeInheritedStaticParameters(StaticParameters.StaticSwitchParameters, AncestorStaticParameters.StaticSwitchParameters);
+		MergeInheritedStaticParameters(StaticParameters.StaticComponentMaskParameters, AncestorStaticParameters.StaticComponentMaskParameters);
+	}
+
+	MaterialInstanceConstant->Parent = Material;
+	if (StaticParameters.StaticSwitchParameters.Num() > 0 || StaticParameters.StaticComponentMaskParameters.Num() > 0)
+	{
+		PendingStaticPermutations.Add(MaterialInstanceConstant, StaticParameters);
+	}
+	return true;
 }
 
-FString T3DLevelParser::RessourceTypeFor(EExportType::Type Type)
+void T3DLevelParser::BindMaterialInstanceParameters()
 {
-	switch (Type)
+	// Instances of the project the import only links to are already bound
+	for (auto Iter = FixedRequirements.CreateConstIterator(); Iter; ++Iter)
 	{
-	case EExportType::Material: return TEXT("Material");
-	case EExportType::StaticMesh: return TEXT("StaticMesh");
-	case EExportType::MaterialInstanceConstant: return TEXT("MaterialInstanceConstant");
-	case EExportType::Texture2D: return TEXT("Texture2D");
-	default: return TEXT("Unknow");
+		UMaterialInstanceConstant * MaterialInstanceConstant = Cast<UMaterialInstanceConstant>(Iter.Value());
+		if (MaterialInstanceConstant && IsImportedAsset(MaterialInstanceConstant))
+		{
+			BindMaterialInstanceParameters(MaterialInstanceConstant);
+		}
 	}
 }
 
-void T3DLevelParser::ExportPackageToRequirements(EExportType::Type Type)
+void T3DLevelParser::BindMaterialInstanceParameters(UMaterialInstanceConstant * MaterialInstanceConstant)
 {
-	FString RessourceType = RessourceTypeFor(Type);
+	UMaterial * Material = MaterialInstanceConstant->GetMaterial();
+	if (Material == NULL || MaterialInstanceConstant->Parent == NULL)
+		return;
 
-	TArray<FString> FileNames;
-	IFileManager::Get().FindFilesRecursive(FileNames, *SourcePath, _T("*.T3D"), true, false);
-	for (int32 NameIdx = 0; NameIdx < FileNames.Num(); NameIdx++)
+	ModifyObject(MaterialInstanceConstant);
+	const FParameterIndex &Index = GetParameterIndex(Material);
+	for (FScalarParameterValue &Parameter : MaterialInstanceConstant->ScalarParameterValues)
 	{
-		FString relPath = FileNames[NameIdx];
-		relPath.RemoveFromEnd(".T3D", ESearchCase::IgnoreCase);
-		relPath.RemoveFromStart((SourcePath + "/"), ESearchCase::IgnoreCase);
-		relPath = relPath.Replace(_T("/"), _T("."));
-		AddRequirement(FString::Printf(TEXT("%s'%s'"), *RessourceType, *relPath), UObjectDelegate());
+		BindParameter(Index, Parameter.ParameterInfo, EParameterType::Scalar, Parameter.ExpressionGUID, MaterialInstanceConstant);
+	}
+	for (FVectorParameterValue &Parameter : MaterialInstanceConstant->VectorParameterValues)
+	{
+		BindParameter(Index, Parameter.ParameterInfo, EParameterType::Vector, Parameter.ExpressionGUID, MaterialInstanceConstant);
+	}
+	for (FTextureParameterValue &Parameter : MaterialInstanceConstant->TextureParameterValues)
+	{
+		BindParameter(Index, Parameter.ParameterInfo, EParameterType::Texture, Parameter.ExpressionGUID, MaterialInstanceConstant);
+	}
+
+	FStaticParameterSet * pStaticParameters = PendingStaticPermutations.Find(MaterialInstanceConstant);
+	if (pStaticParameters != NULL)
+	{
+		for (FStaticSwitchParameter &Parameter : pStaticParameters->StaticSwitchParameters)
+		{
+			BindParameter(Index, Parameter.ParameterInfo, EParameterType::StaticSwitch, Parameter.ExpressionGUID, MaterialInstanceConstant);
+		}
+		for (FStaticComponentMaskParameter &Parameter : pStaticParameters->StaticComponentMaskParameters)
+		{
+			BindParameter(Index, Parameter.ParameterInfo, EParameterType::StaticComponentMask, Parameter.ExpressionGUID, MaterialInstanceConstant);
+		}
 	}
 }
 
-void T3DLevelParser::ResolveRequirements()
+bool T3DLevelParser::BindParameter(const FParameterIndex &Index, const FMaterialParameterInfo &ParameterInfo, EParameterType::Type Type, FGuid &ExpressionGUID, UMaterialInstanceConstant * MaterialInstanceConstant)
 {
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ExportMaterialAssets", "Parsing materials"));
-	ExportMaterialAssets();
+	const FParameterEntry * Entry = Index.Find(ParameterInfo.Name);
+	if (Entry == NULL || Entry->Type != Type)
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Parameter %s of %s does not exist on its parent material"), *ParameterInfo.Name.ToString(), *MaterialInstanceConstant->GetPathName());
+		return false;
+	}
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ExportMaterialInstanceConstantAssets", "Parsing material instances"));
-	ExportMaterialInstanceConstantAssets();
-	
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ResolvingLinks", "Fixing reference with existing assets"));
-	//UTexture2D * DefaultTexture2D = LoadObject<UTexture2D>(NULL, TEXT("/Engine/EngineResources/DefaultTexture.DefaultTexture"));
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	ExpressionGUID = Entry->ExpressionGUID;
+	return true;
+}
+
+bool T3DLevelParser::GatherMaterialCost(const FRequirement &Requirement)
+{
+	UMaterialInterface * MaterialInterface = Cast<UMaterialInterface>(FixedRequirements.FindRef(Requirement));
+	UMaterial * BaseMaterial = MaterialInterface ? MaterialInterface->GetMaterial() : NULL;
+	if (BaseMaterial == NULL)
+		return true;
+
+	// Counts are only meaningful once the shader map is complete, the next step looks again
+	FMaterialResource * Resource = MaterialInterface->GetMaterialResource(GMaxRHIFeatureLevel);
+	if (Resource && !Resource->IsCompilationFinished())
 	{
-		const FRequirement &Requirement = Iter.Key();
+		GShaderCompilingManager->ProcessAsyncResults(true, false);
+		return false;
+	}
 
-		FString ObjectPath = GetPathToUAsset(Requirement.RelDirectory, Requirement.Name);
-		UObject * asset = NULL;
+	FMaterialCost Cost;
+	Cost.Url = Requirement.Url;
+	Cost.SourceFile = GetPathToT3D(Requirement.RelDirectory, Requirement.Name);
+	Cost.Instructions = 0;
+	Cost.Samplers = 0;
+	Cost.bInstance = false;
 
-		if (Requirement.Type == TEXT("StaticMesh"))
-		{
-			asset = LoadObject<UStaticMesh>(NULL, *ObjectPath);
-		}
-		else if (Requirement.Type == TEXT("Material") || Requirement.Type == TEXT("DecalMaterial"))
+	UMaterialInstanceConstant * MaterialInstanceConstant = Cast<UMaterialInstanceConstant>(MaterialInterface);
+	if (MaterialInstanceConstant)
+	{
+		Cost.bInstance = true;
+		if (MaterialInstanceConstant->bHasStaticPermutationResource)
 		{
-			asset = LoadObject<UMaterial>(NULL, *ObjectPath);
+			// Instances only own a shader map when their static parameters differ from the parent,
+			// without overrides they share the parent's default permutation
+			Cost.StaticPermutation = StaticPermutationKey(MaterialInstanceConstant->GetStaticParameters());
+			if (Cost.StaticPermutation.IsEmpty())
+				UniqueShaderMaps.Add(BaseMaterial->GetPathName());
+			else
+				UniqueShaderMaps.Add(BaseMaterial->GetPathName() + TEXT("|") + Cost.StaticPermutation);
 		}
-		else if (Requirement.Type.StartsWith(TEXT("Texture")))
+	}
+	else
+	{
+		UniqueShaderMaps.Add(BaseMaterial->GetPathName());
+	}
+
+	for (int32 Usage = 0; Usage < MATUSAGE_MAX; ++Usage)
+	{
+		if (BaseMaterial->GetUsageByFlag((EMaterialUsage)Usage))
 		{
-			asset = LoadObject<UTexture>(NULL, *ObjectPath);
-			/*if (!asset)
-			{
-				FixRequirement(Requirement, DefaultTexture2D); // Using default texture
-			}*/
+			if (!Cost.Usages.IsEmpty())
+				Cost.Usages += TEXT("|");
+			Cost.Usages += BaseMaterial->GetUsageName((EMaterialUsage)Usage);
 		}
+	}
 
-		if (asset)
+	if (Resource)
+	{
+		TArray<FString> Descriptions;
+		TArray<int32> InstructionCounts;
+		Resource->GetRepresentativeInstructionCounts(Descriptions, InstructionCounts);
+		for (int32 Count : InstructionCounts)
 		{
-			FixRequirement(Requirement, asset);
+			Cost.Instructions = FMath::Max(Cost.Instructions, Count);
 		}
+		Cost.Samplers = Resource->GetSamplerUsage();
 	}
 
+	MaterialCosts.Add(Cost);
+	return true;
+}
+
+void T3DLevelParser::ReportMaterialCosts()
+{
+	if (MaterialCosts.Num() == 0)
+		return;
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ResolvingLinks2", "Update existing assets"));
+	int32 MaterialCount = 0, InstanceCount = 0;
+	for (const FMaterialCost &Cost : MaterialCosts)
+	{
+		if (Cost.bInstance)
+			++InstanceCount;
+		else
+			++MaterialCount;
+	}
 
-	// make sure that any static meshes, etc using this material will stop using the FMaterialResource of the original 
-	// material, and will use the new FMaterialResource created when we make a new UMaterial in place
-	FGlobalComponentReregisterContext RecreateComponents;
+	MaterialCosts.Sort([](const FMaterialCost &A, const FMaterialCost &B)
+	{
+		return A.Instructions != B.Instructions ? A.Instructions > B.Instructions : A.Samplers > B.Samplers;
+	});
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ResolvingLinks3", "Compile materials"));
-	PostEditChangeFor(TEXT("Material"));
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ResolvingLinks4", "Compile material instances"));
-	PostEditChangeFor(TEXT("MaterialInstanceConstant"));
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ResolvingLinks5", "Post edit for meshes"));
-	PostEditChangeFor(TEXT("StaticMesh"));
+	UE_LOG(UDKImportPluginLog, Log, TEXT("Material cost report : %d materials, %d instances, %d unique shader maps"), MaterialCount, InstanceCount, UniqueShaderMaps.Num());
 
-	PrintMissingRequirements();
-	int i = 0;
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	FString Report = TEXT("Url,Instance,Instructions,Samplers,Usages,StaticPermutation,SourceFile\n");
+	for (const FMaterialCost &Cost : MaterialCosts)
 	{
-		const FRequirement& Requirement = Iter.Key();
+		UE_LOG(UDKImportPluginLog, Log, TEXT("%5d instructions %2d samplers %s [%s] (%s) from %s"), Cost.Instructions, Cost.Samplers, *Cost.Url, *Cost.StaticPermutation, *Cost.Usages, *Cost.SourceFile);
+		Report += FString::Printf(TEXT("\"%s\",%d,%d,%d,%s,\"%s\",\"%s\"\n"), *Cost.Url.Replace(TEXT("\""), TEXT("\"\"")), Cost.bInstance ? 1 : 0, Cost.Instructions, Cost.Samplers, *Cost.Usages, *Cost.StaticPermutation, *Cost.SourceFile);
+	}
 
-		FString ObjectPath = GetPathToUAsset(Requirement.RelDirectory, Requirement.Name);
-		LogContent += FString::Printf(TEXT("Failed to find %s '%s'\n"), *Requirement.Type, *ObjectPath);
-		i++;
+	FString ReportPath = ReportDirectory / TEXT("MaterialCosts.csv");
+	if (!FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to write material cost report : %s"), *ReportPath);
 	}
-	if (LogContent != TEXT(""))
-		OpenMsgDialog(LogContent);
 }
 
-void T3DLevelParser::PostEditChangeFor(const FString &Type)
+bool T3DLevelParser::ImportMaterialInstanceConstantFile(const FQueuedRequirement &Queued)
 {
-	for (auto Iter = FixedRequirements.CreateIterator(); Iter; ++Iter)
+	const FRequirement &Requirement = Queued.Requirement;
+	if (!Requirements.Contains(Requirement))
+		return false;
+
+	T3DMaterialInstanceConstantParser MaterialInstanceConstantParser(this, Requirement.RelDirectory);
+	UMaterialInstanceConstant * MaterialInstanceConstant = MaterialInstanceConstantParser.ImportT3DFile(Queued.FileName, Requirement);
+	ProcessedBytes += Queued.Bytes;
+
+	if (MaterialInstanceConstant)
 	{
-		const FRequirement &Requirement = Iter.Key();
-		if (Requirement.Type == Type)
+		FixRequirement(Requirement, MaterialInstanceConstant);
+		return true;
+	}
+
+	ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::ImportFailed, Queued.FileName, 0, Requirement.Url, TEXT("Unable to import material instance"));
+	FailedImports.Add(Requirement.Url);
+	return false;
+}
+
+bool T3DLevelParser::BeginImportMaterialFile(const FQueuedRequirement &Queued)
+{
+	if (!Requirements.Contains(Queued.Requirement))
+		return false;
+
+	// Expressions are imported by the next steps, until EndImportMaterialFile
+	ActiveMaterialParser = MakeShareable(new T3DMaterialParser(this, Queued.Requirement.RelDirectory));
+	if (ActiveMaterialParser->BeginImportMaterialT3DFile(Queued.FileName, Queued.Requirement))
+		return true;
+
+	EndImportMaterialFile(Queued);
+	return false;
+}
+
+void T3DLevelParser::EndImportMaterialFile(const FQueuedRequirement &Queued)
+{
+	TSharedPtr<T3DMaterialParser> MaterialParser = MoveTemp(ActiveMaterialParser);
+	const FRequirement &Requirement = MaterialParser->GetRequirement();
+	UMaterial * Material = MaterialParser->EndImportMaterial();
+	ProcessedBytes += Queued.Bytes;
+
+	if (Material)
+	{
+		FixRequirement(Requirement, Material);
+		return;
+	}
+
+	if (Requirement.Type != Queued.Requirement.Type)
+	{
+		// The file holds an instance, the next phase imports it
+		for (auto Iter = Requirements.CreateIterator(); Iter; ++Iter)
 		{
-			if (Requirement.Name == TEXT("MI_StargateSupport_Base"))
-			{
-				UE_LOG(UDKImportPluginLog, Warning, TEXT("Test Me : %s"), *Requirement.Url);
-			}
-			UObject * Object = Iter.Value();
-			if (Object)
+			if (Iter.Key().Url == Requirement.Url)
 			{
-				Object->PostEditChange();
+				Iter.Key().Type = Requirement.Type;
 			}
 		}
 	}
 }
 
-void T3DLevelParser::ExportMaterialInstanceConstantAssets()
+bool T3DLevelParser::AssetExists(const FString &ObjectPath) const
+{
+	IAssetRegistry &AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	return AssetRegistry.GetAssetByObjectPath(FName(*ObjectPath)).IsValid();
+}
+
+void T3DLevelParser::MarkResolved(const FRequirement &Requirement)
 {
-	bool bRequiresAnotherLoop = false;
+	// No object behind it, later requirements on the same url are resolved without being recorded
+	FixedRequirements.Add(Requirement, NULL);
+	Requirements.Remove(Requirement);
+}
 
-	do
+void T3DLevelParser::AnalyzeLevelFile()
+{
+	UDKIMPORT_SCOPE(AnalyzeLevel);
+	const FString FileName = SourcePath / TEXT("PersistentLevel.T3D");
+	TArray<FString> LevelLines;
+	SourceFile = FileName;
+	if (!LoadFile(FileName, LevelLines))
 	{
-		bRequiresAnotherLoop = false;
-		for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
-		{
-			const FRequirement &Requirement = Iter.Key();
+		Phase = EImportPhase::Done;
+		return;
+	}
 
-			if (Requirement.Type == TEXT("MaterialInstanceConstant"))
-			{
-				FString ObjectPath = GetPathToUAsset(*Requirement.RelDirectory, *Requirement.Name);
-				UMaterialInstanceConstant * MaterialInstanceConstant = NULL; //LoadObject<UMaterialInstanceConstant>(NULL, *ObjectPath, NULL, LOAD_NoWarn | LOAD_Quiet);
-				if (!MaterialInstanceConstant)
-				{
-					T3DMaterialInstanceConstantParser MaterialInstanceConstantParser(this, Requirement.RelDirectory);
-					MaterialInstanceConstant = MaterialInstanceConstantParser.ImportT3DFile(GetPathToT3D(Requirement.RelDirectory, Requirement.Name), Requirement);
-				}
+	ResetParser(MoveTemp(LevelLines));
+	RelDirectory = _T("");
 
-				if (MaterialInstanceConstant)
-				{
-					bRequiresAnotherLoop = true;
-					FixRequirement(Requirement, MaterialInstanceConstant);
-				}
-				else
-				{
-					UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to import : %s"), *Requirement.Url);
-				}
-			}
+	FString Class, Value;
+	ensure(NextLine());
+	while (NextLine() && !IsEndObject())
+	{
+		if (!IsBeginObject(Class))
+			continue;
+
+		// Same actors and references as ImportLevelInternal
+		const bool bSupported = Class == TEXT("StaticMeshActor") || Class == TEXT("Brush") || Class == TEXT("PointLight") || Class == TEXT("SpotLight");
+		Counters.Actors++;
+		(bSupported ? DryRun.Actors : DryRun.SkippedActors).FindOrAdd(Class)++;
+
+		int32 Depth = 1;
+		while (Depth > 0 && NextLine())
+		{
+			Depth += T3DCore::LineDepthDelta(*Line, *Line + Line.Len());
+			if (!bSupported)
+				continue;
+
+			if (GetProperty(TEXT("StaticMesh="), Value))
+				AddRequirement(Value, UObjectDelegate());
+			else if (Line.StartsWith(TEXT("Begin Polygon ")) && GetOneValueAfter(TEXT(" Texture="), Value))
+				AddRequirement(FString::Printf(TEXT("Material'%s'"), *Value), UObjectDelegate());
 		}
-	} while (bRequiresAnotherLoop);
+	}
 }
 
-void T3DLevelParser::ExportMaterialAssets()
+bool T3DLevelParser::AnalyzeMaterialFile(const FQueuedRequirement &Queued)
 {
-	for (auto Iter = Requirements.CreateIterator(); Iter; ++Iter)
+	FRequirement Requirement = Queued.Requirement;
+	if (!Requirements.Contains(Requirement))
+		return false;
+
+	T3DMaterialParser MaterialParser(this, Requirement.RelDirectory);
+	const bool bAnalyzed = MaterialParser.AnalyzeMaterialT3DFile(Queued.FileName, Requirement);
+	ProcessedBytes += Queued.Bytes;
+
+	if (bAnalyzed)
 	{
-		FRequirement &Requirement = Iter.Key();
+		const bool bExists = AssetExists(GetPathToUAsset(Requirement.RelDirectory, Requirement.Name));
+		(bExists ? DryRun.OverwrittenAssets : DryRun.NewAssets).FindOrAdd(TEXT("Material"))++;
+		MarkResolved(Requirement);
+		return true;
+	}
 
-		if (Requirement.Type == TEXT("Material"))
+	if (Requirement.Type != Queued.Requirement.Type)
+	{
+		// The file holds an instance, the next phase analyzes it
+		for (auto Iter = Requirements.CreateIterator(); Iter; ++Iter)
 		{
-			FString ObjectPath = GetPathToUAsset(*Requirement.RelDirectory, *Requirement.Name);
-			UMaterial * Material = NULL;//LoadObject<UMaterial>(NULL, *ObjectPath, NULL, LOAD_NoWarn | LOAD_Quiet);
-			if (!Material)
-			{
-				T3DMaterialParser MaterialParser(this, Requirement.RelDirectory);
-				Material = MaterialParser.ImportMaterialT3DFile(GetPathToT3D(Requirement.RelDirectory, Requirement.Name), Requirement);
-			}
-
-			if (Material)
+			if (Iter.Key().Url == Requirement.Url)
 			{
-				FixRequirement(Requirement, Material);
+				Iter.Key().Type = Requirement.Type;
 			}
 		}
 	}
+	return false;
 }
 
-void T3DLevelParser::ImportLevelInternal()
+bool T3DLevelParser::AnalyzeMaterialInstanceConstantFile(const FQueuedRequirement &Queued)
 {
-	FString Class;
+	const FRequirement &Requirement = Queued.Requirement;
+	if (!Requirements.Contains(Requirement))
+		return false;
 
-	ensure(NextLine());
-	ensure(Line.Equals(TEXT("Begin Object Class=Level Name=PersistentLevel")));
+	T3DMaterialInstanceConstantParser MaterialInstanceConstantParser(this, Requirement.RelDirectory);
+	const bool bAnalyzed = MaterialInstanceConstantParser.AnalyzeT3DFile(Queued.FileName, Requirement);
+	ProcessedBytes += Queued.Bytes;
 
-	while (NextLine() && !IsEndObject())
+	if (bAnalyzed)
 	{
-		if (IsBeginObject(Class))
+		const bool bExists = AssetExists(GetPathToUAsset(Requirement.RelDirectory, Requirement.Name));
+		(bExists ? DryRun.OverwrittenAssets : DryRun.NewAssets).FindOrAdd(TEXT("MaterialInstanceConstant"))++;
+		MarkResolved(Requirement);
+		return true;
+	}
+
+	ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::ImportFailed, Queued.FileName, 0, Requirement.Url, TEXT("Unable to parse material instance"));
+	FailedImports.Add(Requirement.Url);
+	return false;
+}
+
+int32 T3DLevelParser::EstimateShaderMaps() const
+{
+	// One shader map per written material, one more per distinct static permutation of an instance
+	return DryRun.NewAssets.FindRef(TEXT("Material")) + DryRun.OverwrittenAssets.FindRef(TEXT("Material")) + DryRun.StaticPermutations.Num();
+}
+
+void T3DLevelParser::ReportDryRun()
+{
+	for (const FString &Function : DryRun.Functions)
+	{
+		if (!Function.IsEmpty() && !AssetExists(Function))
 		{
-			UObject * Object = 0;
-			if (Class.Equals(TEXT("StaticMeshActor")))
-				ImportStaticMeshActor();
-			else if (Class.Equals(TEXT("Brush")))
-				ImportBrush();
-			else if (Class.Equals(TEXT("PointLight")))
-				ImportPointLight();
-			else if (Class.Equals(TEXT("SpotLight")))
-				ImportSpotLight();
-			else
-				JumpToEnd();
+			ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::MissingFunction, FString(), 0, Function, TEXT("Material function substitution not found"));
 		}
 	}
+
+	for (auto Iter = DryRun.NewAssets.CreateConstIterator(); Iter; ++Iter)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Dry run : %d %s would be created"), Iter.Value(), *Iter.Key());
+	}
+	for (auto Iter = DryRun.OverwrittenAssets.CreateConstIterator(); Iter; ++Iter)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Dry run : %d %s would be overwritten"), Iter.Value(), *Iter.Key());
+	}
+	for (auto Iter = DryRun.Actors.CreateConstIterator(); Iter; ++Iter)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Dry run : %d %s would be spawned"), Iter.Value(), *Iter.Key());
+	}
+	for (auto Iter = DryRun.SkippedActors.CreateConstIterator(); Iter; ++Iter)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Dry run : %d %s would be skipped"), Iter.Value(), *Iter.Key());
+	}
+	for (auto Iter = DryRun.UnsupportedExpressions.CreateConstIterator(); Iter; ++Iter)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Dry run : %d unsupported %s"), Iter.Value(), *Iter.Key());
+	}
+
+	const int32 ShaderMaps = EstimateShaderMaps();
+	const FString Summary = FString::Printf(TEXT("Dry run : %d references resolved, %d unresolved, %d shader maps (about %d shaders) to compile"),
+		FixedRequirements.Num(), Requirements.Num(), ShaderMaps, ShaderMaps * Settings.ShadersPerMaterialEstimate);
+	UE_LOG(UDKImportPluginLog, Log, TEXT("%s"), *Summary);
+	ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Info, FUDKImportDiagnostics::ECode::DryRun, FString(), 0, FString(), Summary);
+
+	const FString ReportPath = ReportDirectory / TEXT("DryRun.json");
+	if (!WriteSummary(ReportPath))
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to write dry run report : %s"), *ReportPath);
+	}
+}
+
+static void WriteCounts(TJsonWriter<> &Writer, const TCHAR * Identifier, const TMap<FString, int32> &Counts)
+{
+	Writer.WriteObjectStart(Identifier);
+	for (auto Iter = Counts.CreateConstIterator(); Iter; ++Iter)
+	{
+		Writer.WriteValue(Iter.Key(), Iter.Value());
+	}
+	Writer.WriteObjectEnd();
+}
+
+void T3DLevelParser::WriteDryRun(TJsonWriter<> &Writer) const
+{
+	const int32 ShaderMaps = EstimateShaderMaps();
+	Writer.WriteObjectStart(TEXT("dryRun"));
+	WriteCounts(Writer, TEXT("created"), DryRun.NewAssets);
+	WriteCounts(Writer, TEXT("overwritten"), DryRun.OverwrittenAssets);
+	WriteCounts(Writer, TEXT("existingReferences"), DryRun.ExistingReferences);
+	WriteCounts(Writer, TEXT("actors"), DryRun.Actors);
+	WriteCounts(Writer, TEXT("skippedActors"), DryRun.SkippedActors);
+	WriteCounts(Writer, TEXT("expressions"), DryRun.Expressions);
+	WriteCounts(Writer, TEXT("unsupportedExpressions"), DryRun.UnsupportedExpressions);
+	Writer.WriteValue(TEXT("staticPermutations"), DryRun.StaticPermutations.Num());
+	Writer.WriteValue(TEXT("estimatedShaderMaps"), ShaderMaps);
+	Writer.WriteValue(TEXT("estimatedShaders"), ShaderMaps * Settings.ShadersPerMaterialEstimate);
+	Writer.WriteObjectEnd();
+}
+
+bool T3DLevelParser::ImportLevelInternal()
+{
+	UDKIMPORT_SCOPE(ImportLevelInternal);
+	UDKIMPORT_LLM_SCOPE(Level);
+	FString Class;
+
+	if (!NextLine() || IsEndObject())
+		return false;
+
+	if (IsBeginObject(Class))
+	{
+		Counters.Actors++;
+		if (Class.Equals(TEXT("StaticMeshActor")))
+			ImportStaticMeshActor();
+		else if (Class.Equals(TEXT("Brush")))
+			ImportBrush();
+		else if (Class.Equals(TEXT("PointLight")))
+			ImportPointLight();
+		else if (Class.Equals(TEXT("SpotLight")))
+			ImportSpotLight();
+		else
+			JumpToEnd();
+	}
+	return true;
 }
 
 void T3DLevelParser::ImportBrush()
 {
+	UDKIMPORT_SCOPE(ImportBrush);
 	FString Value, Class, Name;
 	ABrush * Brush = SpawnActor<ABrush>();
 	Brush->BrushType = Brush_Add;
@@ -317,7 +1981,7 @@ void T3DLevelParser::ImportBrush()
 		}
 	}
 	
-	Model->Modify();
+	ModifyObject(Model);
 	Model->BuildBound();
 
 	Brush->GetBrushComponent()->Brush = Brush->Brush;
@@ -376,8 +2040,174 @@ void T3DLevelParser::ImportPolyList(UPolys * Polys)
 	}
 }
 
+void T3DLevelParser::ConvertBrushesToStaticMeshes()
+{
+	TArray<ABrush*> Brushes;
+	for (const TWeakObjectPtr<AActor> &Actor : SpawnedActors)
+	{
+		ABrush * Brush = Cast<ABrush>(Actor.Get());
+		if (Brush)
+			Brushes.Add(Brush);
+	}
+	if (Brushes.Num() == 0 || World == NULL)
+		return;
+
+	UDKIMPORT_SCOPE(ConvertBrushes);
+	// Evaluate the CSG of the imported brushes once, in their import order, its surfaces come back as polygons
+	// carrying their material. BSP the level already had is left to its own brushes
+	UModel * Model = NewObject<UModel>(GetTransientPackage());
+	Model->Initialize(NULL, 1);
+	for (ABrush * Brush : Brushes)
+	{
+		if (Brush->Brush)
+			GEditor->bspBrushCSG(Brush, Model, Brush->PolyFlags, (EBrushType)Brush->BrushType, CSG_None, false, true, false, false);
+	}
+	GEditor->bspBuildFPolys(Model, true, 0);
+
+	const float CellSize = FMath::Max(Settings.BrushCellSize, 1.f);
+	TMap<FIntVector, TArray<FPoly> > Cells;
+	for (const FPoly &Poly : Model->Polys->Element)
+	{
+		if (Poly.Vertices.Num() < 3)
+			continue;
+
+		FVector Center = FVector::ZeroVector;
+		for (const FVector &Vertex : Poly.Vertices)
+		{
+			Center += Vertex;
+		}
+		Center /= Poly.Vertices.Num();
+		Cells.FindOrAdd(FIntVector(FMath::FloorToInt(Center.X / CellSize), FMath::FloorToInt(Center.Y / CellSize), FMath::FloorToInt(Center.Z / CellSize))).Add(Poly);
+	}
+
+	// One mesh per cell, its sections merge the polygons of each material
+	UModel * CellModel = NewObject<UModel>(GetTransientPackage());
+	CellModel->Initialize(NULL, 1);
+	int32 Converted = 0;
+	for (auto Iter = Cells.CreateConstIterator(); Iter; ++Iter)
+	{
+		const FIntVector &Cell = Iter.Key();
+		const FVector Origin = (FVector(Cell) + FVector(0.5f)) * CellSize;
+		CellModel->Polys->Element.Empty(Iter.Value().Num());
+		for (const FPoly &Poly : Iter.Value())
+		{
+			FPoly &LocalPoly = CellModel->Polys->Element[CellModel->Polys->Element.Add(Poly)];
+			LocalPoly.Base -= Origin;
+			for (FVector &Vertex : LocalPoly.Vertices)
+			{
+				Vertex -= Origin;
+			}
+		}
+
+		const FString Name = FString::Printf(TEXT("BSP_%d_%d_%d"), Cell.X, Cell.Y, Cell.Z);
+		const FString PackageName = TEXT("/Game") / DestPath / TEXT("BSP") / Name;
+		UStaticMesh * StaticMesh = LoadObject<UStaticMesh>(NULL, *(PackageName + TEXT(".") + Name), NULL, LOAD_NoWarn | LOAD_Quiet);
+		if (StaticMesh)
+		{
+			// Mesh of an earlier import, actors placed since keep using it, its geometry and materials are replaced in place
+			TrackAsset(StaticMesh, false);
+			ModifyObject(StaticMesh);
+			FMeshDescription MeshDescription;
+			FStaticMeshAttributes(MeshDescription).Register();
+			TArray<FStaticMaterial> Materials;
+			GetBrushMesh(NULL, CellModel, MeshDescription, Materials);
+			StaticMesh->StaticMaterials = Materials;
+			StaticMesh->CreateMeshDescription(0, MoveTemp(MeshDescription));
+			StaticMesh->CommitMeshDescription(0);
+			StaticMesh->PostEditChange();
+		}
+		else
+		{
+			UPackage * Package = CreatePackage(*PackageName);
+			StaticMesh = CreateStaticMeshFromBrush(Package, FName(*Name), NULL, CellModel);
+			if (StaticMesh == NULL)
+			{
+				UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to convert brushes of cell %s"), *Name);
+				continue;
+			}
+			StaticMesh->MarkPackageDirty();
+			TrackAsset(StaticMesh, true);
+			PendingRegistryNotifications.Add(StaticMesh);
+		}
+
+		AStaticMeshActor * StaticMeshActor = SpawnActor<AStaticMeshActor>();
+		StaticMeshActor->SetActorLocation(Origin);
+		StaticMeshActor->GetStaticMeshComponent()->SetStaticMesh(StaticMesh);
+		StaticMeshActor->SetActorLabel(Name);
+		++Converted;
+	}
+
+	// The meshes replace the imported brushes, the level BSP is rebuilt from the brushes it had before
+	for (ABrush * Brush : Brushes)
+	{
+		World->EditorDestroyActor(Brush, true);
+	}
+	GEditor->csgRebuild(World);
+	World->InvalidateModelGeometry(World->PersistentLevel);
+	World->PersistentLevel->UpdateModelComponents();
+	UE_LOG(UDKImportPluginLog, Log, TEXT("%d brushes converted into %d static meshes"), Brushes.Num(), Converted);
+}
+
+void T3DLevelParser::SetupHierarchicalLOD()
+{
+	if (World == NULL)
+		return;
+
+	// Actors are clustered by the cell holding the center of their bounds, actors larger than a cell stay out
+	const float ClusterSize = FMath::Max(Settings.HLODClusterSize, 1.f);
+	TMap<FIntVector, TArray<AActor*> > Clusters;
+	for (const TWeakObjectPtr<AActor> &Actor : SpawnedActors)
+	{
+		AStaticMeshActor * StaticMeshActor = Cast<AStaticMeshActor>(Actor.Get());
+		if (StaticMeshActor == NULL || StaticMeshActor->GetStaticMeshComponent()->GetStaticMesh() == NULL)
+			continue;
+
+		FVector Origin, Extent;
+		StaticMeshActor->GetActorBounds(false, Origin, Extent);
+		if (Extent.GetMax() * 2.f > ClusterSize)
+			continue;
+
+		Clusters.FindOrAdd(FIntVector(FMath::FloorToInt(Origin.X / ClusterSize), FMath::FloorToInt(Origin.Y / ClusterSize), FMath::FloorToInt(Origin.Z / ClusterSize))).Add(StaticMeshActor);
+	}
+	if (Clusters.Num() == 0)
+		return;
+
+	UDKIMPORT_SCOPE(SetupHierarchicalLOD);
+	AWorldSettings * WorldSettings = World->GetWorldSettings();
+	ModifyObject(WorldSettings);
+	WorldSettings->bEnableHierarchicalLODSystem = true;
+	TArray<FHierarchicalSimplification> &LODSetup = WorldSettings->GetHierarchicalLODSetup();
+	if (LODSetup.Num() == 0)
+		LODSetup.AddDefaulted();
+	LODSetup[0].DesiredBoundRadius = ClusterSize * 0.5f * FMath::Sqrt(3.f);
+
+	FHierarchicalLODUtilitiesModule &Module = FModuleManager::LoadModuleChecked<FHierarchicalLODUtilitiesModule>("HierarchicalLODUtilities");
+	IHierarchicalLODUtilities * Utilities = Module.GetUtilities();
+	int32 Clustered = 0, ClusterCount = 0;
+	for (auto Iter = Clusters.CreateConstIterator(); Iter; ++Iter)
+	{
+		// A single actor gains nothing from a proxy mesh
+		if (Iter.Value().Num() < 2)
+			continue;
+
+		ALODActor * LODActor = Utilities->CreateNewClusterActor(World, 0, WorldSettings);
+		if (LODActor == NULL)
+			continue;
+
+		SpawnedActors.Add(LODActor);
+		for (AActor * Actor : Iter.Value())
+		{
+			Utilities->AddActorToCluster(Actor, LODActor);
+		}
+		Clustered += Iter.Value().Num();
+		++ClusterCount;
+	}
+	UE_LOG(UDKImportPluginLog, Log, TEXT("%d actors assigned to %d HLOD clusters"), Clustered, ClusterCount);
+}
+
 void T3DLevelParser::ImportPointLight()
 {
+	UDKIMPORT_SCOPE(ImportPointLight);
 	FString Value, Class;
 	APointLight* PointLight = SpawnActor<APointLight>();
 
@@ -420,6 +2250,7 @@ void T3DLevelParser::ImportPointLight()
 
 void T3DLevelParser::ImportSpotLight()
 {
+	UDKIMPORT_SCOPE(ImportSpotLight);
 	FVector DrawScale3D(1.0,1.0,1.0);
 	FRotator Rotator(0.0, 0.0, 0.0);
 	FString Value, Class, Name;
@@ -483,6 +2314,7 @@ void T3DLevelParser::ImportSpotLight()
 
 void T3DLevelParser::ImportStaticMeshActor()
 {
+	UDKIMPORT_SCOPE(ImportStaticMeshActor);
 	FString Value, Class;
 	FVector PrePivot;
 	bool bPrePivotFound = false;
@@ -576,18 +2408,24 @@ void T3DLevelParser::SetStaticMeshMaterial(UObject * Material, FString StaticMes
 void T3DLevelParser::SetStaticMeshMaterialResolved(UObject * Object, UObject * Material, int32 MaterialIdx)
 {
 	UStaticMesh * StaticMesh = Cast<UStaticMesh>(Object);
+	if (StaticMesh == NULL)
+		return;
 
-	check(StaticMesh->RenderData);
-	FMeshSectionInfo Info = StaticMesh->GetSectionInfoMap().Get(0, MaterialIdx);
+	if (StaticMesh->RenderData == NULL)
+	{
+		ImportDiagnostics.Add(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::ImportFailed, FString(), 0, StaticMesh->GetPathName(), FString::Printf(TEXT("%s has no render data, material slot %d is not assigned"), *StaticMesh->GetPathName(), MaterialIdx));
+		return;
+	}
 
+	// The mesh is rebuilt once with all its slots, see EFinalizeStep::BuildStaticMeshes
+	TrackModifiedAsset(StaticMesh);
+	ModifyObject(StaticMesh);
+	FMeshSectionInfo Info = StaticMesh->GetSectionInfoMap().Get(0, MaterialIdx);
 	if (MaterialIdx >= StaticMesh->StaticMaterials.Num())
 		StaticMesh->StaticMaterials.SetNum(MaterialIdx + 1);
 	Info.MaterialIndex = MaterialIdx;
 	StaticMesh->GetSectionInfoMap().Set(0, MaterialIdx, Info);
 	StaticMesh->SetMaterial(MaterialIdx, Cast<UMaterialInterface>(Material));
-
-	StaticMesh->Modify();
-	StaticMesh->PostEditChange();
 }
 
 void T3DLevelParser::SetTexture(UObject * Object, UMaterialExpressionTextureBase * MaterialExpression)
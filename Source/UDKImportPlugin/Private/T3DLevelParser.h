@@ -1,9 +1,11 @@
 #pragma once
 
 #include "T3DParser.h"
+#include "UDKImportSettings.h"
 
 class T3DMaterialParser;
 class T3DMaterialInstanceConstantParser;
+class FGlobalComponentReregisterContext;
 
 class T3DLevelParser : public T3DParser
 {
@@ -15,7 +17,45 @@ public:
 	void ImportStaticMesh();
 	void ImportMaterial();
 	void ImportMaterialInstanceConstant();
-	FString LogContent = TEXT("");
+
+	/// Incremental import, the blocking Import* functions above and FUDKImportTask drive the same steps
+	void BeginImportLevel();
+	void BeginImportStaticMesh();
+	void BeginImportMaterial();
+	void BeginImportMaterialInstanceConstant();
+	/** Run import steps for about TimeBudget seconds, returns true once the import is done or cancelled */
+	bool TickImport(double TimeBudget);
+	/** Stop at the next step and delete what this import wrote, ignored once packages are being saved */
+	void CancelImport();
+	bool IsImportCancelled() const;
+	float GetImportProgress() const;
+	FText GetImportStatus() const;
+	void AddReferencedObjects(FReferenceCollector &Collector);
+
+	void SetWorld(UWorld * InWorld);
+	/** Only import these T3D files, references to other files are resolved from saved assets */
+	void SetShardFiles(const TArray<FString> &Files);
+	/** Directory receiving Diagnostics.json, Memory.csv, MaterialCosts.csv and DryRun.json, Saved/UDKImport by default */
+	void SetReportDirectory(const FString &Directory);
+	bool WriteSummary(const FString &FileName) const;
+	FUDKImportDiagnostics ImportDiagnostics;
+	FUDKImportSettings Settings;
+
+	/// Work done by this import, for throughput measurements
+	struct FImportCounters
+	{
+		int32 Files;
+		int64 Bytes;
+		int64 Lines;
+		int64 Expressions;
+		int32 Actors;
+
+		FImportCounters() : Files(0), Bytes(0), Lines(0), Expressions(0), Actors(0)
+		{}
+	};
+	FImportCounters Counters;
+	/** Highest physical memory use sampled while this import ran, unlike the process peak it ignores earlier work */
+	uint64 GetPeakUsedPhysical() const;
 
 private:
 	// Export tools
@@ -31,14 +71,236 @@ private:
 		};
 	};
 	FString RessourceTypeFor(EExportType::Type Type);
-	void ImportRessource(EExportType::Type Type);
+	void BeginImportRessource(EExportType::Type Type);
 	void ExportPackageToRequirements(EExportType::Type Type);
 
+	/// Class of every T3D file of the source tree, sniffed from its first line
+	TMap<FString, FString> SourceClasses;
+	TSet<FString> ShardFiles;
+	FString ReportDirectory;
+	void BuildSourceIndex();
+	void RetypeRequirementsFromSource();
+
+	/// Import steps, each call to StepImport does one file or one requirement
+	struct EImportPhase
+	{
+		enum Type
+		{
+			Level,
+			Materials,
+			MaterialInstanceConstants,
+			ResolveLinks,
+			Finalize,
+			Done,
+			Cancelled
+		};
+	};
+	/// Finalize steps, in order, FinalizeImport returns true once the current one is done.
+	/// Steps working on several objects take one object, or one batch, per call
+	struct EFinalizeStep
+	{
+		enum Type
+		{
+			PrepareAssets,
+			CompileMaterials,
+			CompileStaticPermutations,
+			WaitForShaders,
+			CompileMaterialInstances,
+			BuildStaticMeshes,
+			ReportMaterialCosts,
+			SavePackages,
+			Report
+		};
+	};
+	struct FQueuedRequirement
+	{
+		FRequirement Requirement;
+		FString FileName;
+		int64 Bytes;
+	};
+	EImportPhase::Type Phase;
+	TArray<FQueuedRequirement> PhaseQueue;
+	int32 PhaseIndex;
+	EFinalizeStep::Type FinalizeStep;
+	bool bFinalizeStepStarted;
+	bool bPhaseImportedAssets;
+	bool bCancelRequested;
+	TSet<FString> FailedImports;
+	/// Level and material files are read across several steps, one actor or expression at a time
+	bool bLevelFileOpen;
+	TSharedPtr<T3DMaterialParser> ActiveMaterialParser;
+	void BeginImport(EImportPhase::Type FirstPhase);
+	void EnterPhase(EImportPhase::Type NewPhase);
+	void StepImport();
+	void RunImport(const FText &Title);
+	void RollbackImport();
+
+	/// Memory used by each phase and by each importer subsystem, reported once the import is done
+	struct FMemorySnapshot
+	{
+		FString Phase;
+		uint64 UsedPhysical;
+		uint64 PhasePeakUsedPhysical;
+		uint64 PeakUsedPhysical;
+		int64 ParserBytes;
+		int32 PrefetchedFiles;
+		int64 RequirementBytes;
+		int32 PendingDelegates;
+		int64 CacheBytes;
+		int32 CreatedObjects;
+		int64 CreatedObjectBytes;
+	};
+	TArray<FMemorySnapshot> MemorySnapshots;
+	bool bPhaseStarted;
+	uint64 PhasePeakUsedPhysical;
+	static const TCHAR * PhaseName(EImportPhase::Type ImportPhase);
+	void SnapshotMemory();
+	void ReportMemory() const;
+
+	/// Byte based progress of the file phases
+	int64 TotalBytes, ProcessedBytes;
+	double FilePhaseStartTime;
+	FString CurrentFile;
+
+	/// T3D files are read and split into lines on worker threads, ahead of the step using them
+	struct FT3DFile
+	{
+		bool bLoaded;
+		int64 Bytes;
+		TArray<FString> Lines;
+	};
+	typedef TSharedPtr<FT3DFile, ESPMode::ThreadSafe> FT3DFilePtr;
+	TMap<FString, TFuture<FT3DFilePtr> > PrefetchedFiles;
+	void PrefetchFile(const FString &FileName);
+	void PrefetchQueue();
+	bool LoadFile(const FString &FileName, TArray<FString> &OutLines);
+
+	/// Everything written by this import, undone when it is cancelled
+	TArray<TWeakObjectPtr<UObject> > CreatedAssets;
+	TArray<TWeakObjectPtr<UPackage> > OverwrittenPackages;
+	TArray<TWeakObjectPtr<AActor> > SpawnedActors;
+	void TrackAsset(UObject * Asset, bool bCreated);
+	/** Track an asset about to be modified, unless this import created it */
+	void TrackModifiedAsset(UObject * Asset);
+	/** True for assets this import created or overwrote, fix-ups leave other project assets alone */
+	bool IsImportedAsset(UObject * Asset) const;
+
+	/// New assets are created directly and announced to the asset registry in one pass
+	TArray<TWeakObjectPtr<UObject> > PendingRegistryNotifications;
+	UObject * CreateAsset(const FString &Name, const FString &PackagePath, UClass * Class, UFactory * Factory);
+	void NotifyCreatedAssets();
+
+	/// Packages created or modified by this import, saved in batches once it is done
+	TSet<TWeakObjectPtr<UPackage> > TouchedPackages;
+	TArray<UPackage*> PackagesToSave;
+	int32 SaveIndex;
+	int32 SavedPackages;
+	TArray<FString> SaveFailures;
+	void CollectPackagesToSave();
+
+	/// Imported files still referencing assets another shard writes
+	TArray<FString> IncompleteFiles;
+	void CollectIncompleteFiles();
+	bool SavePackageBatch();
+
+	/// Bulk imports only mark packages dirty, they never feed the undo buffer
+	void ModifyObject(UObject * Object);
+	void EndBulkImport();
+
+	/// Dry runs parse and resolve everything, but create, compile and save nothing
+	struct FDryRunReport
+	{
+		TMap<FString, int32> NewAssets;
+		TMap<FString, int32> OverwrittenAssets;
+		TMap<FString, int32> ExistingReferences;
+		TMap<FString, int32> Actors;
+		TMap<FString, int32> SkippedActors;
+		TMap<FString, int32> Expressions;
+		TMap<FString, int32> UnsupportedExpressions;
+		TSet<FString> Functions;
+		TSet<FString> StaticPermutations;
+	};
+	FDryRunReport DryRun;
+	bool AssetExists(const FString &ObjectPath) const;
+	void MarkResolved(const FRequirement &Requirement);
+	void AnalyzeLevelFile();
+	bool AnalyzeMaterialFile(const FQueuedRequirement &Queued);
+	bool AnalyzeMaterialInstanceConstantFile(const FQueuedRequirement &Queued);
+	int32 EstimateShaderMaps() const;
+	void ReportDryRun();
+	void WriteDryRun(TJsonWriter<> &Writer) const;
+
 	/// Ressources requirements
-	void ResolveRequirements();
-	void ExportMaterialInstanceConstantAssets();
-	void ExportMaterialAssets();
-	void PostEditChangeFor(const FString &Type);
+	bool BeginImportLevelFile();
+	bool BeginImportMaterialFile(const FQueuedRequirement &Queued);
+	void EndImportMaterialFile(const FQueuedRequirement &Queued);
+	bool ImportMaterialInstanceConstantFile(const FQueuedRequirement &Queued);
+	void ResolveRequirement(const FRequirement &Requirement);
+	bool FinalizeImport(EFinalizeStep::Type Step);
+	/** Queue every fixed requirement of Type for the current finalize step, except objects in Skip */
+	void QueueFixedRequirements(const FString &Type, const TSet<UObject*> &Skip = TSet<UObject*>());
+	/** PostEditChange the next queued requirement, returns true once the queue is done */
+	bool PostEditChangeNext();
+	/** Returns true once no shader is left to compile, never blocks */
+	bool WaitForShaderCompilation();
+	/// Components stay unregistered while materials and meshes are rebuilt, across the steps doing it
+	TSharedPtr<FGlobalComponentReregisterContext> ComponentReregisterContext;
+	TMap<UMaterialInstanceConstant*, FStaticParameterSet> PendingStaticPermutations;
+	void ApplyStaticPermutations();
+
+	/// Parameters exposed by a parent material, indexed once and shared by all its instances
+	struct EParameterType
+	{
+		enum Type
+		{
+			Scalar,
+			Vector,
+			Texture,
+			StaticSwitch,
+			StaticComponentMask
+		};
+	};
+	struct FParameterEntry
+	{
+		EParameterType::Type Type;
+		FGuid ExpressionGUID;
+	};
+	typedef TMap<FName, FParameterEntry> FParameterIndex;
+	TMap<UMaterial*, FParameterIndex> ParameterIndices;
+	const FParameterIndex & GetParameterIndex(UMaterial * Material);
+	/// Samplers reading the alpha of a texture, normal maps among them are rebuilt once in a batch
+	TSet<TWeakObjectPtr<UMaterialExpressionTextureBase> > AlphaSamplers;
+	void ApplyTextureFixups();
+
+	void FlattenInstanceChains();
+	bool FlattenInstanceChain(UMaterialInstanceConstant * MaterialInstanceConstant);
+	void BindMaterialInstanceParameters();
+	void BindMaterialInstanceParameters(UMaterialInstanceConstant * MaterialInstanceConstant);
+	bool BindParameter(const FParameterIndex &Index, const FMaterialParameterInfo &ParameterInfo, EParameterType::Type Type, FGuid &ExpressionGUID, UMaterialInstanceConstant * MaterialInstanceConstant);
+	struct FMaterialCost
+	{
+		FString Url;
+		FString SourceFile;
+		FString Usages;
+		FString StaticPermutation;
+		int32 Instructions;
+		int32 Samplers;
+		bool bInstance;
+	};
+	TArray<FMaterialCost> MaterialCosts;
+	TSet<FString> UniqueShaderMaps;
+	/** Gather the cost of a material or instance, returns false while its shaders are still compiling */
+	bool GatherMaterialCost(const FRequirement &Requirement);
+	void ReportMaterialCosts();
+	static FString StaticPermutationKey(const FStaticParameterSet &StaticParameters);
+	void EnforceSamplerBudget();
+	void EnforceSamplerBudget(UMaterial * Material);
+
+	/// Material functions replacing UDK expressions, loaded once per import
+	TMap<FString, UMaterialFunctionInterface*> Substitutions;
+	TMap<FString, int32> PendingSubstitutionLoads;
+	void PreloadSubstitutions();
+	UMaterialFunctionInterface * GetSubstitution(const FString &ExpressionClass);
 
 	/// Actor creation
 	UWorld * World;
@@ -46,9 +308,12 @@ private:
 	T * SpawnActor();
 
 	/// Actor Importation
-	void ImportLevelInternal();
+	/** Import the next actor of the level, returns false once the level is read */
+	bool ImportLevelInternal();
 	void ImportBrush();
 	void ImportPolyList(UPolys * Polys);
+	void ConvertBrushesToStaticMeshes();
+	void SetupHierarchicalLOD();
 	void ImportStaticMeshActor();
 	void ImportPointLight();
 	void ImportSpotLight();
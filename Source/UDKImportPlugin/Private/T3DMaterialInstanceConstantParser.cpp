@@ -7,15 +7,16 @@ T3DMaterialInstanceConstantParser::T3DMaterialInstanceConstantParser(T3DLevelPar
 	this->LevelParser = ParentParser;
 	this->RelDirectory = RelDirectory;
 	this->MaterialInstanceConstant = NULL;
+	this->Diagnostics = ParentParser->Diagnostics;
 }
 
 UMaterialInstanceConstant* T3DMaterialInstanceConstantParser::ImportT3DFile(const FString &FileName, const FRequirement &req)
 {
-	FString MaterialT3D;
-	if (FFileHelper::LoadFileToString(MaterialT3D, *FileName))
+	TArray<FString> MaterialLines;
+	SourceFile = FileName;
+	if (LevelParser->LoadFile(FileName, MaterialLines))
 	{
-		ResetParser(MaterialT3D);
-		MaterialT3D.Empty();
+		ResetParser(MoveTemp(MaterialLines));
 		return ImportMaterialInstanceConstant(req);
 	}
 
@@ -24,6 +25,8 @@ UMaterialInstanceConstant* T3DMaterialInstanceConstantParser::ImportT3DFile(cons
 
 UMaterialInstanceConstant*  T3DMaterialInstanceConstantParser::ImportMaterialInstanceConstant(const FRequirement &req)
 {
+	UDKIMPORT_SCOPE(ImportMaterialInstanceConstant);
+	UDKIMPORT_LLM_SCOPE(Assets);
 	FString ClassName, Name, Value;
 	int32 ParameterIndex;
 
@@ -32,16 +35,17 @@ UMaterialInstanceConstant*  T3DMaterialInstanceConstantParser::ImportMaterialIns
 	ensure(ClassName == TEXT("MaterialInstanceConstant"));
 	ensure(GetOneValueAfter(TEXT(" Name="), Name));
 
-	FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
-	UMaterialInstanceConstantFactoryNew* MaterialFactory = NewObject<UMaterialInstanceConstantFactoryNew>(UMaterialInstanceConstantFactoryNew::StaticClass());
 	FString ObjectPath = GetPathToUAsset(*req.RelDirectory, *req.Name);
+	INC_DWORD_STAT(STAT_UDKImport_SyncLoads);
 	MaterialInstanceConstant = LoadObject<UMaterialInstanceConstant>(NULL, *ObjectPath, NULL, LOAD_NoWarn | LOAD_Quiet);
 	if (MaterialInstanceConstant == NULL)
 	{
-		MaterialInstanceConstant = (UMaterialInstanceConstant*)AssetToolsModule.Get().CreateAsset(Name, GetPathToDirectory(req.RelDirectory), UMaterialInstanceConstant::StaticClass(), MaterialFactory);
+		UMaterialInstanceConstantFactoryNew* MaterialFactory = NewObject<UMaterialInstanceConstantFactoryNew>(UMaterialInstanceConstantFactoryNew::StaticClass());
+		MaterialInstanceConstant = (UMaterialInstanceConstant*)LevelParser->CreateAsset(Name, GetPathToDirectory(req.RelDirectory), UMaterialInstanceConstant::StaticClass(), MaterialFactory);
 	}
 	else
 	{
+		LevelParser->TrackAsset(MaterialInstanceConstant, false);
 		MaterialInstanceConstant->TextureParameterValues.Empty();
 		MaterialInstanceConstant->ScalarParameterValues.Empty();
 		MaterialInstanceConstant->VectorParameterValues.Empty();
@@ -52,7 +56,7 @@ UMaterialInstanceConstant*  T3DMaterialInstanceConstantParser::ImportMaterialIns
 		return NULL;
 	}
 
-	MaterialInstanceConstant->Modify();
+	LevelParser->ModifyObject(MaterialInstanceConstant);
 
 	while (NextLine() && IgnoreSubObjects() && !IsEndObject())
 	{
@@ -84,7 +88,6 @@ UMaterialInstanceConstant*  T3DMaterialInstanceConstantParser::ImportMaterialIns
 					UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to parse ressource url : %s"), *Value);
 				}
 			}
-			SetSwitchParameter(MaterialInstanceConstant, Parameter.ParameterInfo, true, true);
 		}
 		else if (IsParameter(TEXT("ScalarParameterValues"), ParameterIndex, Value))
 		{
@@ -116,6 +119,14 @@ UMaterialInstanceConstant*  T3DMaterialInstanceConstantParser::ImportMaterialIns
 			if (GetOneValueAfter(TEXT("ParameterValue="), Value))
 				Parameter.ParameterValue.InitFromString(Value);
 		}
+		else if (IsParameter(TEXT("StaticSwitchParameters"), ParameterIndex, Value))
+		{
+			ImportStaticSwitchParameter();
+		}
+		else if (IsParameter(TEXT("StaticComponentMaskParameters"), ParameterIndex, Value))
+		{
+			ImportStaticComponentMaskParameter();
+		}
 		else if (GetProperty(TEXT("Parent="), Value))
 		{
 			FRequirement Requirement;
@@ -135,38 +146,119 @@ UMaterialInstanceConstant*  T3DMaterialInstanceConstantParser::ImportMaterialIns
 		}
 	}
 
-	/*
-	for (int32 CheckIdx = 0; CheckIdx < MaterialInstanceConstant->TextureParameterValues.Num(); CheckIdx++)
+	if (StaticParameters.StaticSwitchParameters.Num() > 0 || StaticParameters.StaticComponentMaskParameters.Num() > 0)
+	{
+		// The parent may not be imported yet, the level parser applies every permutation at once
+		LevelParser->PendingStaticPermutations.Add(MaterialInstanceConstant, StaticParameters);
+	}
+
+	LevelParser->ModifyObject(MaterialInstanceConstant); // Might force save changes to materials
+
+	return MaterialInstanceConstant;
+}
+
+bool T3DMaterialInstanceConstantParser::AnalyzeT3DFile(const FString &FileName, const FRequirement &req)
+{
+	TArray<FString> MaterialLines;
+	SourceFile = FileName;
+	if (LevelParser->LoadFile(FileName, MaterialLines))
 	{
-		auto param = &MaterialInstanceConstant->TextureParameterValues[CheckIdx];
-		param->ExpressionGUID = GetGuid(MaterialInstanceConstant, param->ParameterInfo.Name);
+		ResetParser(MoveTemp(MaterialLines));
+		return AnalyzeMaterialInstanceConstant(req);
 	}
-	for (int32 CheckIdx = 0; CheckIdx < MaterialInstanceConstant->VectorParameterValues.Num(); CheckIdx++)
+
+	return false;
+}
+
+bool T3DMaterialInstanceConstantParser::AnalyzeMaterialInstanceConstant(const FRequirement &req)
+{
+	UDKIMPORT_SCOPE(AnalyzeMaterialInstanceConstant);
+	FString ClassName, Value, ParentUrl;
+	int32 ParameterIndex;
+
+	ensure(NextLine());
+	ensure(IsBeginObject(ClassName));
+	if (ClassName != TEXT("MaterialInstanceConstant"))
+		return false;
+
+	while (NextLine() && IgnoreSubObjects() && !IsEndObject())
 	{
-		auto param = &MaterialInstanceConstant->VectorParameterValues[CheckIdx];
-		param->ExpressionGUID = GetGuid(MaterialInstanceConstant, param->ParameterInfo.Name);
+		FRequirement Requirement;
+		if (IsBeginObject(ClassName))
+		{
+			JumpToEnd();
+		}
+		else if (IsParameter(TEXT("TextureParameterValues"), ParameterIndex, Value))
+		{
+			if (GetOneValueAfter(TEXT("ParameterValue="), Value) && ParseRessourceUrl(Value, Requirement))
+				LevelParser->AddRequirement(Requirement, UObjectDelegate());
+		}
+		else if (IsParameter(TEXT("StaticSwitchParameters"), ParameterIndex, Value))
+		{
+			ImportStaticSwitchParameter();
+		}
+		else if (IsParameter(TEXT("StaticComponentMaskParameters"), ParameterIndex, Value))
+		{
+			ImportStaticComponentMaskParameter();
+		}
+		else if (GetProperty(TEXT("Parent="), Value) && ParseRessourceUrl(Value, Requirement))
+		{
+			ParentUrl = Requirement.Url;
+			LevelParser->AddRequirement(Requirement, UObjectDelegate());
+		}
 	}
-	for (int32 CheckIdx = 0; CheckIdx < MaterialInstanceConstant->ScalarParameterValues.Num(); CheckIdx++)
+
+	// Instances sharing a parent and the same overrides share a shader map. Without overrides they use
+	// the parent's default permutation, which the estimate already counts with the parent material
+	const FString StaticPermutation = T3DLevelParser::StaticPermutationKey(StaticParameters);
+	if (!StaticPermutation.IsEmpty())
 	{
-		auto param = &MaterialInstanceConstant->ScalarParameterValues[CheckIdx];
-		param->ExpressionGUID = GetGuid(MaterialInstanceConstant, param->ParameterInfo.Name);
-	}*/
-
-	// Enable all statics as I don't know how to query for these
-	/*FStaticParameterSet CompositedStaticParameters;
-	MaterialInstanceConstant->GetStaticParameterValues(CompositedStaticParameters);
-	for (int32 CheckIdx = 0; CheckIdx < CompositedStaticParameters.StaticSwitchParameters.Num(); CheckIdx++)
+		LevelParser->DryRun.StaticPermutations.Add(ParentUrl + TEXT("|") + StaticPermutation);
+	}
+
+	return true;
+}
+
+void T3DMaterialInstanceConstantParser::ImportStaticSwitchParameter()
+{
+	FString Value;
+	FStaticSwitchParameter Parameter;
+	if (GetOneValueAfter(TEXT("ParameterName="), Value))
 	{
-		FStaticSwitchParameter& SwitchParam = CompositedStaticParameters.StaticSwitchParameters[CheckIdx];
-		SwitchParam.bOverride = true;
-		SwitchParam.Value = true;
+		Value.RemoveFromStart("\"");
+		Value.RemoveFromEnd("\"");
+		Parameter.ParameterInfo.Name = *Value;
 	}
+	if (GetOneValueAfter(TEXT(",Value="), Value))
+		Parameter.Value = Value.ToBool();
+	Parameter.bOverride = !GetOneValueAfter(TEXT("bOverride="), Value) || Value.ToBool();
 
-	MaterialInstanceConstant->UpdateStaticPermutation(CompositedStaticParameters);
-	*/
-	MaterialInstanceConstant->Modify(); // Might force save changes to materials
+	if (Parameter.bOverride && !Parameter.ParameterInfo.Name.IsNone())
+		StaticParameters.StaticSwitchParameters.Add(Parameter);
+}
 
-	return MaterialInstanceConstant;
+void T3DMaterialInstanceConstantParser::ImportStaticComponentMaskParameter()
+{
+	FString Value;
+	FStaticComponentMaskParameter Parameter;
+	if (GetOneValueAfter(TEXT("ParameterName="), Value))
+	{
+		Value.RemoveFromStart("\"");
+		Value.RemoveFromEnd("\"");
+		Parameter.ParameterInfo.Name = *Value;
+	}
+	if (GetOneValueAfter(TEXT(",R="), Value))
+		Parameter.R = Value.ToBool();
+	if (GetOneValueAfter(TEXT(",G="), Value))
+		Parameter.G = Value.ToBool();
+	if (GetOneValueAfter(TEXT(",B="), Value))
+		Parameter.B = Value.ToBool();
+	if (GetOneValueAfter(TEXT(",A="), Value))
+		Parameter.A = Value.ToBool();
+	Parameter.bOverride = !GetOneValueAfter(TEXT("bOverride="), Value) || Value.ToBool();
+
+	if (Parameter.bOverride && !Parameter.ParameterInfo.Name.IsNone())
+		StaticParameters.StaticComponentMaskParameters.Add(Parameter);
 }
 
 bool T3DMaterialInstanceConstantParser::IsParameter(const FString &Key, int32 &index, FString &Value)
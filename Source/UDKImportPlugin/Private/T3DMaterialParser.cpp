@@ -7,56 +7,69 @@ T3DMaterialParser::T3DMaterialParser(T3DLevelParser * ParentParser, const FStrin
 	this->LevelParser = ParentParser;
 	this->RelDirectory = RelDirectory;
 	this->Material = NULL;
+	this->bDecal = false;
+	this->Diagnostics = ParentParser->Diagnostics;
 }
 
 UMaterial* T3DMaterialParser::ImportMaterialT3DFile(const FString &FileName, FRequirement &req)
 {
-	FString MaterialT3D;
-	if (FFileHelper::LoadFileToString(MaterialT3D, *FileName))
+	UMaterial * Result = NULL;
+	if (BeginImportMaterialT3DFile(FileName, req))
 	{
-		ResetParser(MaterialT3D);
-		MaterialT3D.Empty();
-		return ImportMaterial(req);
+		while (StepImportMaterial())
+		{}
+		Result = EndImportMaterial();
+	}
+	req = MaterialRequirement;
+	return Result;
+}
+
+bool T3DMaterialParser::BeginImportMaterialT3DFile(const FString &FileName, const FRequirement &req)
+{
+	TArray<FString> MaterialLines;
+	MaterialRequirement = req;
+	SourceFile = FileName;
+	if (LevelParser->LoadFile(FileName, MaterialLines))
+	{
+		ResetParser(MoveTemp(MaterialLines));
+		return BeginImportMaterial();
 	}
 
-	return NULL;
+	return false;
 }
 
-UMaterial*  T3DMaterialParser::ImportMaterial(FRequirement &req)
+bool T3DMaterialParser::BeginImportMaterial()
 {
-	FString ClassName, Name, Value;
-	UClass * Class;
+	UDKIMPORT_SCOPE(ImportMaterial);
+	UDKIMPORT_LLM_SCOPE(Assets);
+	FString ClassName, Name;
 
 	ensure(NextLine());
 	ensure(IsBeginObject(ClassName));
-	if (ClassName == TEXT("TextureCube"))
-	{
-		OpenMsgDialog(FString::Printf(TEXT("Trying to import %s as material is not supported (%s)"), *ClassName, *req.OriginalUrl));
-		return NULL;
-	}
 	if (ClassName == TEXT("MaterialInstanceConstant"))
 	{
-		req.Type = TEXT("MaterialInstanceConstant");
-		return NULL;
+		MaterialRequirement.Type = TEXT("MaterialInstanceConstant");
+		return false;
 	}
 	if (ClassName != TEXT("Material") && ClassName != TEXT("DecalMaterial"))
 	{
-		OpenMsgDialog(FString::Printf(TEXT("Trying to import %s as material is not supported (%s)"), *ClassName, *req.OriginalUrl));
-		return NULL;
+		AddDiagnostic(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::UnsupportedClass, MaterialRequirement.OriginalUrl, FString::Printf(TEXT("Trying to import %s as material is not supported"), *ClassName));
+		return false;
 	}
 	ensure(GetOneValueAfter(TEXT(" Name="), Name));
 
-	FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
-	UMaterialFactoryNew* MaterialFactory = NewObject<UMaterialFactoryNew>(UMaterialFactoryNew::StaticClass());
-	FString path = GetPathToDirectory(req.RelDirectory) / Name;
-	FString ObjectPath = GetPathToUAsset(*req.RelDirectory, *req.Name);
+	MaterialPath = GetPathToDirectory(MaterialRequirement.RelDirectory) / Name;
+	FString ObjectPath = GetPathToUAsset(*MaterialRequirement.RelDirectory, *MaterialRequirement.Name);
+	INC_DWORD_STAT(STAT_UDKImport_SyncLoads);
 	Material = LoadObject<UMaterial>(NULL, *ObjectPath, NULL, LOAD_NoWarn | LOAD_Quiet);
 	if (Material == NULL)
 	{
-		Material = (UMaterial*)AssetToolsModule.Get().CreateAsset(Name, GetPathToDirectory(req.RelDirectory), UMaterial::StaticClass(), MaterialFactory);
+		UMaterialFactoryNew* MaterialFactory = NewObject<UMaterialFactoryNew>(UMaterialFactoryNew::StaticClass());
+		Material = (UMaterial*)LevelParser->CreateAsset(Name, GetPathToDirectory(MaterialRequirement.RelDirectory), UMaterial::StaticClass(), MaterialFactory);
 	}
 	else
 	{
+		LevelParser->TrackAsset(Material, false);
 		// We're overwriting it, empty data
 		Material->EditorComments.Empty();
 		Material->Expressions.Empty();
@@ -72,206 +85,290 @@ UMaterial*  T3DMaterialParser::ImportMaterial(FRequirement &req)
 	}
 	if (Material == NULL)
 	{
-		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to import : %s"), *req.Url);
-		return NULL;
+		AddDiagnostic(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::ImportFailed, MaterialRequirement.Url, TEXT("Unable to create the material"));
+		return false;
 	}
 
-	Material->Modify();
-	bool isDecal = false;
+	LevelParser->ModifyObject(Material);
+	bDecal = false;
 	if(ClassName == TEXT("DecalMaterial"))
 	{
 		Material->MaterialDomain = EMaterialDomain::MD_DeferredDecal;
-		isDecal = true;
+		bDecal = true;
 	}
+	return true;
+}
 
-	while (NextLine() && !IsEndObject())
+bool T3DMaterialParser::StepImportMaterial()
+{
+	UDKIMPORT_SCOPE(ImportMaterial);
+	UDKIMPORT_LLM_SCOPE(Assets);
+	FString ClassName, Name, Value;
+	UClass * Class;
+
+	if (!NextLine() || IsEndObject())
+		return false;
+
+	if (IsBeginObject(ClassName))
 	{
-		if (IsBeginObject(ClassName))
+		FString previousClassName = ClassName;
+		bool remapped = RemapExpressionClass(ClassName);
+		if (IsUnsupportedExpressionClass(ClassName))
 		{
-			FString previousClassName;
-			bool remapped = false;
-			if (ClassName == TEXT("MaterialExpressionReflectionVector"))
-			{
-				previousClassName = ClassName;
-				ClassName = TEXT("MaterialExpressionReflectionVectorWS");
-				remapped = true;
-			}
-			else if (ClassName == TEXT("MaterialExpressionConstantClamp"))
-			{
-				previousClassName = ClassName;
-				ClassName = TEXT("MaterialExpressionClamp");
-				remapped = true;
-			}
-			else if (ClassName == TEXT("MaterialExpressionCameraVector"))
-			{
-				previousClassName = ClassName;
-				ClassName = TEXT("MaterialExpressionCameraVectorWS");
-				remapped = true;
-			}
-			else if (ClassName == TEXT("MaterialExpressionDestDepth"))
-			{
-				previousClassName = ClassName;
-				ClassName = TEXT("MaterialExpressionSceneDepth");
-				remapped = true;
-			}
-			else if (ClassName == TEXT("MaterialExpressionMeshEmitterVertexColor"))
-			{
-				previousClassName = ClassName;
-				ClassName = TEXT("MaterialExpressionParticleColor");
-				remapped = true;
-			}
-			else if (ClassName == TEXT("MaterialExpressionMeshSubUV"))
-			{
-				previousClassName = ClassName;
-				ClassName = TEXT("MaterialExpressionTextureSample");
-				remapped = true;
-			}
-			else if (ClassName == TEXT("MaterialExpressionDestColor"))
+			AddDiagnostic(FUDKImportDiagnostics::ESeverity::Warning, FUDKImportDiagnostics::ECode::UnsupportedExpression, MaterialPath, FString::Printf(TEXT("Importer does not support material node type %s, you will have to fix it manually"), *ClassName));
+			//JumpToEnd();
+			return true;
+		}
+
+		if (ClassName == TEXT("MaterialExpressionFlipBookSample"))
+		{
+			Class = UMaterialExpressionTextureSample::StaticClass();
+		}
+		else
+		{
+			Class = FindExpressionClass(ClassName);
+		}
+
+		if (Class)
+		{
+			ensure(GetOneValueAfter(TEXT(" Name="), Name));
+
+			FRequirement TextureRequirement;
+			auto prevLineIndex = LineIndex;
+			const int32 prevLinkCount = ExpressionLinks.Num();
+			UMaterialExpression* MaterialExpression = ImportMaterialExpression(Class, TextureRequirement);
+
+			if (remapped && ClassName == TEXT("MaterialExpressionMaterialFunctionCall"))
 			{
-				previousClassName = ClassName;
-				ClassName = TEXT("MaterialExpressionSceneColor");
-				remapped = true;
+				auto funcCall = Cast<UMaterialExpressionMaterialFunctionCall>(MaterialExpression);
+				funcCall->SetMaterialFunction(LevelParser->GetSubstitution(previousClassName));
 			}
-			else if (ClassName == TEXT("MaterialExpressionLightVector"))
+			
+			if (TextureRequirement.Type == "TextureCube" && ClassName == TEXT("MaterialExpressionTextureSample"))
 			{
 				previousClassName = ClassName;
-				ClassName = TEXT("MaterialExpressionMaterialFunctionCall");
+				ClassName = TEXT("MaterialExpressionTextureSampleParameterCube");
 				remapped = true;
-			}
-			else if (
-				ClassName == TEXT("MaterialExpressionDepthBiasedAlpha") 
-				|| ClassName == TEXT("MaterialExpressionDepthBiasedBlend")
-				|| ClassName == TEXT("MaterialExpressionLensFlareRadialDistance")
-				|| ClassName == TEXT("MaterialExpressionLensFlareIntensity")
-				|| ClassName == TEXT("MaterialExpressionLensFlareOcclusion")
-				|| ClassName == TEXT("MaterialExpressionTextureSampleParameterMovie"))
-			{
-				this->LevelParser->LogContent += FString::Printf(TEXT("Importer does not support material node type %s on %s, you will have to fix it manually\n"), *ClassName, *path);
-				//JumpToEnd();
-				continue;
+				Class = (UClass*)StaticFindObject(UClass::StaticClass(), ANY_PACKAGE, *ClassName, true);
+				LineIndex = prevLineIndex;
+				// Links into the inputs of the discarded sampler go with it, so does the texture action bound to it,
+				// nothing keeps the sampler alive until the texture is resolved
+				ExpressionLinks.SetNum(prevLinkCount);
+				LevelParser->RemoveLastRequirementAction(TextureRequirement);
+				MaterialExpression = ImportMaterialExpression(Class, TextureRequirement);
 			}
 
-			if (ClassName == TEXT("MaterialExpressionFlipBookSample"))
+			UMaterialExpressionComment * MaterialExpressionComment = Cast<UMaterialExpressionComment>(MaterialExpression);
+			if (MaterialExpressionComment)
 			{
-				Class = UMaterialExpressionTextureSample::StaticClass();
+				Material->EditorComments.Add(MaterialExpressionComment);
+				MaterialExpressionComment->MaterialExpressionEditorX -= MaterialExpressionComment->SizeX;
 			}
-			else
+			else if (MaterialExpression)
 			{
-				Class = (UClass*)StaticFindObject(UClass::StaticClass(), ANY_PACKAGE, *ClassName, true);
+				Material->Expressions.Add(MaterialExpression);
 			}
 
-			if (Class)
+			if (MaterialExpression)
 			{
-				ensure(GetOneValueAfter(TEXT(" Name="), Name));
-
-				FRequirement TextureRequirement;
-				auto prevLineIndex = LineIndex;
-				UMaterialExpression* MaterialExpression = ImportMaterialExpression(Class, TextureRequirement);
-
-				if(previousClassName == TEXT("MaterialExpressionLightVector"))
-				{
-					auto funcCall = Cast<UMaterialExpressionMaterialFunctionCall>(MaterialExpression);
-					UMaterialFunctionInterface* funcInterface = LoadObject<UMaterialFunctionInterface>(NULL, _TEXT("/Game/LightVectorProxy.LightVectorProxy"));
-					funcCall->SetMaterialFunction(funcInterface);
-				}
-				
-				if (TextureRequirement.Type == "TextureCube" && ClassName == TEXT("MaterialExpressionTextureSample"))
-				{
-					previousClassName = ClassName;
-					ClassName = TEXT("MaterialExpressionTextureSampleParameterCube");
-					remapped = true;
-					Class = (UClass*)StaticFindObject(UClass::StaticClass(), ANY_PACKAGE, *ClassName, true);
-					LineIndex = prevLineIndex;
-					MaterialExpression = ImportMaterialExpression(Class, TextureRequirement);
-				}
-
-				UMaterialExpressionComment * MaterialExpressionComment = Cast<UMaterialExpressionComment>(MaterialExpression);
-				if (MaterialExpressionComment)
-				{
-					Material->EditorComments.Add(MaterialExpressionComment);
-					MaterialExpressionComment->MaterialExpressionEditorX -= MaterialExpressionComment->SizeX;
-				}
-				else if (MaterialExpression)
-				{
-					Material->Expressions.Add(MaterialExpression);
-				}
-
-				if (MaterialExpression)
-				{
-					if (remapped)
-						FixRequirement(FString::Printf(TEXT("%s'%s'"), *previousClassName, *Name), MaterialExpression);
-					FixRequirement(FString::Printf(TEXT("%s'%s'"), *ClassName, *Name), MaterialExpression);
-				}
-
-				if (ClassName == TEXT("MaterialExpressionFlipBookSample"))
-				{
-					ImportMaterialExpressionFlipBookSample((UMaterialExpressionTextureSample *)MaterialExpression, TextureRequirement);
-				}
+				AddExpressionSymbol(Name, MaterialExpression);
 			}
-			else
+
+			if (ClassName == TEXT("MaterialExpressionFlipBookSample"))
 			{
-				OpenMsgDialog(FString::Printf(TEXT("Couldn't find material node class for '%s' %s"), *ClassName, *req.OriginalUrl));
-				JumpToEnd();
+				ImportMaterialExpressionFlipBookSample((UMaterialExpressionTextureSample *)MaterialExpression, TextureRequirement);
 			}
 		}
-		else if (GetProperty(TEXT("DiffuseColor="), Value))
-		{
-			ImportExpression(&Material->BaseColor);
-		}
-		else if (GetProperty(TEXT("SpecularColor="), Value))
-		{
-			ImportExpression(&Material->Specular);
-		}
-		else if (GetProperty(TEXT("SpecularPower="), Value))
+		else
 		{
-			// TODO
+			AddDiagnostic(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::UnknownExpressionClass, MaterialRequirement.OriginalUrl, FString::Printf(TEXT("Couldn't find material node class for '%s'"), *ClassName));
+			JumpToEnd();
 		}
-		else if (GetProperty(TEXT("Normal="), Value))
-		{
-			ImportExpression(&Material->Normal);
-		}
-		else if (GetProperty(TEXT("EmissiveColor="), Value))
+	}
+	else if (GetProperty(TEXT("DiffuseColor="), Value))
+	{
+		ImportExpression(&Material->BaseColor);
+	}
+	else if (GetProperty(TEXT("SpecularColor="), Value))
+	{
+		ImportExpression(&Material->Specular);
+	}
+	else if (GetProperty(TEXT("SpecularPower="), Value))
+	{
+		// TODO
+	}
+	else if (GetProperty(TEXT("Normal="), Value))
+	{
+		ImportExpression(&Material->Normal);
+	}
+	else if (GetProperty(TEXT("EmissiveColor="), Value))
+	{
+		ImportExpression(&Material->EmissiveColor);
+	}
+	else if (GetProperty(TEXT("Opacity="), Value))
+	{
+		ImportExpression(&Material->Opacity);
+	}
+	else if (GetProperty(TEXT("OpacityMask="), Value))
+	{
+		ImportExpression(&Material->OpacityMask);
+	}
+	else if (IsProperty(Name, Value) && Name != "PreviewMesh"/*I don't need it and it requires additional work to be supported*/)
+	{
+		FProperty* Property = FindFProperty<FProperty>(UMaterial::StaticClass(), *Name);
+		if (Property)
 		{
-			ImportExpression(&Material->EmissiveColor);
+			Property->ImportText(*Value, Property->ContainerPtrToValuePtr<uint8>(Material), 0, Material);
 		}
-		else if (GetProperty(TEXT("Opacity="), Value))
+	}
+
+	return true;
+}
+
+UMaterial * T3DMaterialParser::EndImportMaterial()
+{
+	if (Material == NULL)
+		return NULL;
+
+	ResolveExpressionLinks();
+	WireFlipBookSamples();
+	if (bDecal)
+	{
+		Material->MaterialDomain = EMaterialDomain::MD_DeferredDecal;
+		Material->BlendMode = EBlendMode::BLEND_Translucent;
+		Material->DecalBlendMode = EDecalBlendMode::DBM_DBuffer_Color; // Modulate is not supported with DBuffer decals and Forward Rendering, might as well push everything to color
+	}
+
+	LevelParser->ModifyObject(Material); // Might force save changes to materials
+
+	ReportMissingRequirements();
+
+	return Material;
+}
+
+bool T3DMaterialParser::AnalyzeMaterialT3DFile(const FString &FileName, FRequirement &req)
+{
+	TArray<FString> MaterialLines;
+	SourceFile = FileName;
+	if (LevelParser->LoadFile(FileName, MaterialLines))
+	{
+		ResetParser(MoveTemp(MaterialLines));
+		return AnalyzeMaterial(req);
+	}
+
+	return false;
+}
+
+bool T3DMaterialParser::AnalyzeMaterial(FRequirement &req)
+{
+	UDKIMPORT_SCOPE(AnalyzeMaterial);
+	FString ClassName, Value;
+
+	ensure(NextLine());
+	ensure(IsBeginObject(ClassName));
+	if (ClassName == TEXT("MaterialInstanceConstant"))
+	{
+		req.Type = TEXT("MaterialInstanceConstant");
+		return false;
+	}
+	if (ClassName != TEXT("Material") && ClassName != TEXT("DecalMaterial"))
+	{
+		AddDiagnostic(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::UnsupportedClass, req.OriginalUrl, FString::Printf(TEXT("Trying to import %s as material is not supported"), *ClassName));
+		return false;
+	}
+
+	// Same decisions as ImportMaterial, without creating any expression
+	T3DLevelParser::FDryRunReport &Report = LevelParser->DryRun;
+	while (NextLine() && !IsEndObject())
+	{
+		if (!IsBeginObject(ClassName))
+			continue;
+
+		const FString UDKClassName = ClassName;
+		RemapExpressionClass(ClassName);
+		UClass * Class = ClassName == TEXT("MaterialExpressionFlipBookSample") ? UMaterialExpressionTextureSample::StaticClass() : FindExpressionClass(ClassName);
+		if (IsUnsupportedExpressionClass(ClassName) || Class == NULL)
 		{
-			ImportExpression(&Material->Opacity);
+			AddDiagnostic(FUDKImportDiagnostics::ESeverity::Warning, Class ? FUDKImportDiagnostics::ECode::UnsupportedExpression : FUDKImportDiagnostics::ECode::UnknownExpressionClass, req.OriginalUrl, FString::Printf(TEXT("Importer does not support material node type %s"), *UDKClassName));
+			Report.UnsupportedExpressions.FindOrAdd(UDKClassName)++;
+			JumpToEnd();
+			continue;
 		}
-		else if (GetProperty(TEXT("OpacityMask="), Value))
+
+		Report.Expressions.FindOrAdd(ClassName)++;
+		LevelParser->Counters.Expressions++;
+		const FString * FunctionPath = LevelParser->Settings.FunctionSubstitutions.Find(UDKClassName);
+		if (FunctionPath != NULL)
 		{
-			ImportExpression(&Material->OpacityMask);
+			Report.Functions.Add(*FunctionPath);
 		}
-		else if (IsProperty(Name, Value) && Name != "PreviewMesh"/*I don't need it and it requires additional work to be supported*/)
+
+		while (NextLine() && IgnoreSubs() && !IsEndObject())
 		{
-			FProperty* Property = FindFProperty<FProperty>(UMaterial::StaticClass(), *Name);
-			if (Property)
+			FRequirement TextureRequirement;
+			if (GetProperty(TEXT("Texture="), Value) && ParseRessourceUrl(Value, TextureRequirement))
 			{
-				Property->ImportText(*Value, Property->ContainerPtrToValuePtr<uint8>(Material), 0, Material);
+				LevelParser->AddRequirement(TextureRequirement, UObjectDelegate());
 			}
 		}
 	}
 
-	if (isDecal)
+	return true;
+}
+
+bool T3DMaterialParser::RemapExpressionClass(FString &ClassName) const
+{
+	static const TCHAR * Remaps[][2] =
 	{
-		Material->MaterialDomain = EMaterialDomain::MD_DeferredDecal;
-		Material->BlendMode = EBlendMode::BLEND_Translucent;
-		Material->DecalBlendMode = EDecalBlendMode::DBM_DBuffer_Color; // Modulate is not supported with DBuffer decals and Forward Rendering, might as well push everything to color
+		{ TEXT("MaterialExpressionReflectionVector"), TEXT("MaterialExpressionReflectionVectorWS") },
+		{ TEXT("MaterialExpressionConstantClamp"), TEXT("MaterialExpressionClamp") },
+		{ TEXT("MaterialExpressionCameraVector"), TEXT("MaterialExpressionCameraVectorWS") },
+		{ TEXT("MaterialExpressionDestDepth"), TEXT("MaterialExpressionSceneDepth") },
+		{ TEXT("MaterialExpressionMeshEmitterVertexColor"), TEXT("MaterialExpressionParticleColor") },
+		{ TEXT("MaterialExpressionMeshSubUV"), TEXT("MaterialExpressionTextureSample") },
+		{ TEXT("MaterialExpressionDestColor"), TEXT("MaterialExpressionSceneColor") },
+	};
+
+	// Substitutions come first, the flip book one is wired around a texture sample
+	if (ClassName != TEXT("MaterialExpressionFlipBookSample") && LevelParser->Settings.FunctionSubstitutions.Contains(ClassName))
+	{
+		ClassName = TEXT("MaterialExpressionMaterialFunctionCall");
+		return true;
 	}
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Remaps); ++Index)
+	{
+		if (ClassName == Remaps[Index][0])
+		{
+			ClassName = Remaps[Index][1];
+			return true;
+		}
+	}
+	return false;
+}
 
-	Material->Modify(); // Might force save changes to materials
-
-	PrintMissingRequirements();
+bool T3DMaterialParser::IsUnsupportedExpressionClass(const FString &ClassName)
+{
+	return ClassName == TEXT("MaterialExpressionDepthBiasedAlpha")
+		|| ClassName == TEXT("MaterialExpressionDepthBiasedBlend")
+		|| ClassName == TEXT("MaterialExpressionLensFlareRadialDistance")
+		|| ClassName == TEXT("MaterialExpressionLensFlareIntensity")
+		|| ClassName == TEXT("MaterialExpressionLensFlareOcclusion")
+		|| ClassName == TEXT("MaterialExpressionTextureSampleParameterMovie");
+}
 
-	return Material;
+UClass * T3DMaterialParser::FindExpressionClass(const FString &ClassName)
+{
+	return (UClass*)StaticFindObject(UClass::StaticClass(), ANY_PACKAGE, *ClassName, true);
 }
 
 UMaterialExpression* T3DMaterialParser::ImportMaterialExpression(UClass * Class, FRequirement &TextureRequirement)
 {
+	UDKIMPORT_SCOPE(ImportMaterialExpression);
 	if (!Class->IsChildOf(UMaterialExpression::StaticClass()))
 		return NULL;
 	
 	UMaterialExpression* MaterialExpression = NewObject<UMaterialExpression>(Material, Class);
+	LevelParser->Counters.Expressions++;
 
 	FString Value, Name, PropertyName, Type, PackageName;
 	while (NextLine() && IgnoreSubs() && !IsEndObject())
@@ -355,8 +452,23 @@ UMaterialExpression* T3DMaterialParser::ImportMaterialExpression(UClass * Class,
 
 void T3DMaterialParser::ImportMaterialExpressionFlipBookSample(UMaterialExpressionTextureSample * Expression, FRequirement &TextureRequirement)
 {
+	// The function replacing flip books is configurable, it needs the Rows, Columns and UVs inputs of the default one
+	UMaterialFunctionInterface * FlipBookFunction = LevelParser->GetSubstitution(TEXT("MaterialExpressionFlipBookSample"));
+	if (FlipBookFunction == NULL)
+	{
+		AddDiagnostic(FUDKImportDiagnostics::ESeverity::Warning, FUDKImportDiagnostics::ECode::MissingFunction, MaterialPath, TEXT("No flip book function, the flip book sampler is imported as a plain texture sample"));
+		return;
+	}
+
 	UMaterialExpressionMaterialFunctionCall * MEFunction = NewObject<UMaterialExpressionMaterialFunctionCall>(Material, UMaterialExpressionMaterialFunctionCall::StaticClass());
 	MEFunction->Material = Material;
+	MEFunction->SetMaterialFunction(FlipBookFunction);
+	if (MEFunction->FunctionInputs.Num() < 5)
+	{
+		AddDiagnostic(FUDKImportDiagnostics::ESeverity::Error, FUDKImportDiagnostics::ECode::MissingFunction, MaterialPath, FString::Printf(TEXT("Flip book function %s has %d inputs instead of 5, the flip book sampler is imported as a plain texture sample"), *FlipBookFunction->GetPathName(), MEFunction->FunctionInputs.Num()));
+		return;
+	}
+
 	UMaterialExpressionConstant * MECRows = NewObject<UMaterialExpressionConstant>(Material, UMaterialExpressionConstant::StaticClass());
 	MECRows->Material = Material;
 	UMaterialExpressionConstant * MECCols = NewObject<UMaterialExpressionConstant>(Material, UMaterialExpressionConstant::StaticClass());
@@ -372,16 +484,9 @@ void T3DMaterialParser::ImportMaterialExpressionFlipBookSample(UMaterialExpressi
 	MECRows->bCollapsed = true;
 	MECCols->bCollapsed = true;
 
-	MEFunction->SetMaterialFunction(LoadObject<UMaterialFunction>(NULL, TEXT("/Engine/Functions/Engine_MaterialFunctions02/Texturing/FlipBook.FlipBook")));
-
 	MEFunction->FunctionInputs[1].Input.Expression = MECRows;
 	MEFunction->FunctionInputs[2].Input.Expression = MECCols;
 
-	if (Expression->Coordinates.Expression)
-	{
-		MEFunction->FunctionInputs[4].Input.Expression = Expression->Coordinates.Expression;
-	}
-
 	FString ExportFolder;
 	FString FileName = TextureRequirement.Name + TEXT(".T3D");
 	//LevelParser->ExportPackage(TextureRequirement.RelDirectory, T3DLevelParser::EExportType::Texture2DInfo, ExportFolder);
@@ -398,14 +503,30 @@ void T3DMaterialParser::ImportMaterialExpressionFlipBookSample(UMaterialExpressi
 		}
 	}
 
-	Expression->Coordinates.OutputIndex = 2;
-	Expression->Coordinates.Expression = MEFunction;
+	PendingFlipBooks.Add(Expression, MEFunction);
 
 	Material->Expressions.Add(MECRows);
 	Material->Expressions.Add(MECCols);
 	Material->Expressions.Add(MEFunction);
 }
 
+void T3DMaterialParser::WireFlipBookSamples()
+{
+	for (auto Iter = PendingFlipBooks.CreateConstIterator(); Iter; ++Iter)
+	{
+		UMaterialExpressionTextureSample * Expression = Iter.Key();
+		UMaterialExpressionMaterialFunctionCall * MEFunction = Iter.Value();
+		if (Expression->Coordinates.Expression)
+		{
+			MEFunction->FunctionInputs[4].Input.Expression = Expression->Coordinates.Expression;
+		}
+
+		Expression->Coordinates.OutputIndex = 2;
+		Expression->Coordinates.Expression = MEFunction;
+	}
+	PendingFlipBooks.Empty();
+}
+
 void T3DMaterialParser::ImportExpression(FExpressionInput * ExpressionInput)
 {
 	FString Value;
@@ -420,23 +541,62 @@ void T3DMaterialParser::ImportExpression(FExpressionInput * ExpressionInput)
 	if (GetOneValueAfter(TEXT(",MaskA="), Value))
 		ExpressionInput->MaskA = FCString::Atoi(*Value);
 	if (GetOneValueAfter(TEXT("(Expression="), Value))
-		AddRequirement(Value, UObjectDelegate::CreateRaw(this, &T3DMaterialParser::SetExpression, ExpressionInput));
+	{
+		// Links look like Class'Name', expression names are unique inside the material so the name is enough
+		int32 Begin, End;
+		if (!Value.FindChar(TEXT('\''), Begin) || !Value.FindLastChar(TEXT('\''), End) || End <= Begin + 1)
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to parse expression link : %s"), *Value);
+			return;
+		}
+		for (int32 Index = End - 1; Index > Begin; --Index)
+		{
+			if (Value[Index] == TEXT('.') || Value[Index] == TEXT(':'))
+			{
+				Begin = Index;
+				break;
+			}
+		}
+
+		FExpressionLink &Link = ExpressionLinks[ExpressionLinks.AddUninitialized()];
+		Link.Name = FName(End - Begin - 1, *Value + Begin + 1);
+		Link.ExpressionInput = ExpressionInput;
+		Link.LineIndex = LineIndex;
+	}
 }
 
-void T3DMaterialParser::SetExpression(UObject * Object, FExpressionInput * ExpressionInput)
+void T3DMaterialParser::AddExpressionSymbol(const FString &Name, UMaterialExpression * Expression)
+{
+	ExpressionSymbols.Add(FName(*Name), SymbolExpressions.Add(Expression));
+}
+
+void T3DMaterialParser::ResolveExpressionLinks()
+{
+	for (const FExpressionLink &Link : ExpressionLinks)
+	{
+		const int32 * pIndex = ExpressionSymbols.Find(Link.Name);
+		if (pIndex != NULL)
+		{
+			SetExpression(SymbolExpressions[*pIndex], Link.ExpressionInput);
+		}
+		else if (Diagnostics != NULL)
+		{
+			Diagnostics->Add(FUDKImportDiagnostics::ESeverity::Warning, FUDKImportDiagnostics::ECode::MissingRequirement, SourceFile, Link.LineIndex, MaterialPath, FString::Printf(TEXT("Failed to find expression '%s'"), *Link.Name.ToString()));
+		}
+	}
+	ExpressionLinks.Empty();
+	ExpressionSymbols.Empty();
+	SymbolExpressions.Empty();
+}
+
+void T3DMaterialParser::SetExpression(UMaterialExpression * Expression, FExpressionInput * ExpressionInput)
 {
-	UMaterialExpression * Expression = Cast<UMaterialExpression>(Object);
 	ExpressionInput->Expression = Expression;
-	UMaterialExpressionTextureBase* asTex = Cast<UMaterialExpressionTextureBase>(Object);
-	if(asTex && ExpressionInput->MaskA >= 1 && asTex->Texture->CompressionSettings == TC_Normalmap)
-	{
-		// Normalmaps compression do not keep the alpha channel while this node requires it, 
-		// change normal map settings and sampler type to support alpha
-		asTex->Texture->Modify();
-		asTex->Texture->CompressionSettings = TC_Default;
-		asTex->Texture->PostEditChange();
-		asTex->Modify();
-		asTex->SamplerType = SAMPLERTYPE_LinearColor;
-		asTex->PostEditChange();
+	UMaterialExpressionTextureBase* asTex = Cast<UMaterialExpressionTextureBase>(Expression);
+	if(asTex && ExpressionInput->MaskA >= 1)
+	{
+		// Normalmaps compression do not keep the alpha channel while this node requires it,
+		// their settings and sampler type are changed once, after every material is parsed
+		LevelParser->AlphaSamplers.Add(asTex);
 	}
 }
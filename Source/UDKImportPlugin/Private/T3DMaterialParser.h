@@ -9,16 +9,50 @@ class T3DMaterialParser : public T3DParser
 public:
 	T3DMaterialParser(T3DLevelParser * ParentParser, const FString &RelDirectory);
 	UMaterial * ImportMaterialT3DFile(const FString &FileName, FRequirement &freq);
+	/// Resumable import, ImportMaterialT3DFile runs the same steps at once
+	bool BeginImportMaterialT3DFile(const FString &FileName, const FRequirement &freq);
+	/** Import the next expression or property, returns false once the material is read */
+	bool StepImportMaterial();
+	UMaterial * EndImportMaterial();
+	/** Requirement being imported, retyped when the file holds an instance */
+	const FRequirement & GetRequirement() const { return MaterialRequirement; }
+	/** Dry run counterpart of ImportMaterialT3DFile, records what the import would do in the level parser report */
+	bool AnalyzeMaterialT3DFile(const FString &FileName, FRequirement &freq);
 
 private:
 	T3DLevelParser * LevelParser;
 	
 	// T3D Parsing
-	UMaterial * ImportMaterial(FRequirement &freq);
+	bool BeginImportMaterial();
 	UMaterial * Material;
+	FRequirement MaterialRequirement;
+	FString MaterialPath;
+	bool bDecal;
+	bool AnalyzeMaterial(FRequirement &freq);
+
+	/// Expression classes
+	bool RemapExpressionClass(FString &ClassName) const;
+	static bool IsUnsupportedExpressionClass(const FString &ClassName);
+	static UClass * FindExpressionClass(const FString &ClassName);
 
 	UMaterialExpression* ImportMaterialExpression(UClass * Class, FRequirement &TextureRequirement);
 	void ImportExpression(FExpressionInput * ExpressionInput);
 	void ImportMaterialExpressionFlipBookSample(UMaterialExpressionTextureSample * Expression, FRequirement &TextureRequirement);
-	void SetExpression(UObject * Object, FExpressionInput * ExpressionInput);
+	void SetExpression(UMaterialExpression * Expression, FExpressionInput * ExpressionInput);
+
+	/// Expressions of this material by name, inputs are linked to them once every expression is read
+	struct FExpressionLink
+	{
+		FName Name;
+		FExpressionInput * ExpressionInput;
+		int32 LineIndex;
+	};
+	TMap<FName, int32> ExpressionSymbols;
+	TArray<UMaterialExpression*> SymbolExpressions;
+	TArray<FExpressionLink> ExpressionLinks;
+	void AddExpressionSymbol(const FString &Name, UMaterialExpression * Expression);
+	void ResolveExpressionLinks();
+	/** Flip book samplers take their UDK coordinates through the flip book function, wired once links are resolved */
+	TMap<UMaterialExpressionTextureSample*, UMaterialExpressionMaterialFunctionCall*> PendingFlipBooks;
+	void WireFlipBookSamples();
 };
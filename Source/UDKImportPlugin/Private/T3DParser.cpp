@@ -1,8 +1,37 @@
 ﻿#include "T3DParser.h"
 #include "UDKImportPluginPrivatePCH.h"
+#include "T3DCore/T3DLineParser.h"
 
 DEFINE_LOG_CATEGORY(UDKImportPluginLog);
 
+DEFINE_STAT(STAT_UDKImport_ResetParser);
+DEFINE_STAT(STAT_UDKImport_ImportMaterial);
+DEFINE_STAT(STAT_UDKImport_ImportMaterialExpression);
+DEFINE_STAT(STAT_UDKImport_ImportMaterialInstanceConstant);
+DEFINE_STAT(STAT_UDKImport_AddRequirement);
+DEFINE_STAT(STAT_UDKImport_ResolveRequirements);
+DEFINE_STAT(STAT_UDKImport_PostEditChangeFor);
+DEFINE_STAT(STAT_UDKImport_ImportLevelInternal);
+DEFINE_STAT(STAT_UDKImport_ImportBrush);
+DEFINE_STAT(STAT_UDKImport_ImportStaticMeshActor);
+DEFINE_STAT(STAT_UDKImport_ImportPointLight);
+DEFINE_STAT(STAT_UDKImport_ImportSpotLight);
+DEFINE_STAT(STAT_UDKImport_LinesParsed);
+DEFINE_STAT(STAT_UDKImport_RequirementsAdded);
+DEFINE_STAT(STAT_UDKImport_RequirementsFixed);
+DEFINE_STAT(STAT_UDKImport_SyncLoads);
+DEFINE_STAT(STAT_UDKImport_ParserMemory);
+DEFINE_STAT(STAT_UDKImport_RequirementMemory);
+DEFINE_STAT(STAT_UDKImport_CacheMemory);
+DEFINE_STAT(STAT_UDKImport_PendingDelegates);
+DEFINE_STAT(STAT_UDKImport_CreatedObjects);
+#if UDKIMPORT_LLM_ENABLED
+DEFINE_STAT(STAT_UDKImportLLM_Parser);
+DEFINE_STAT(STAT_UDKImportLLM_Requirements);
+DEFINE_STAT(STAT_UDKImportLLM_Assets);
+DEFINE_STAT(STAT_UDKImportLLM_Level);
+#endif
+
 float T3DParser::UnrRotToDeg = 0.00549316540360483;
 float T3DParser::IntensityMultiplier = 5000;
 
@@ -10,41 +39,37 @@ T3DParser::T3DParser(const FString &SourcePath, const FString &DestPath)
 {
 	this->SourcePath = SourcePath;
 	this->DestPath = DestPath;
-}
-
-inline bool IsWhitespace(TCHAR c) 
-{ 
-	return c == LITERAL(TCHAR, ' ') || c == LITERAL(TCHAR, '\t') || c == LITERAL(TCHAR, '\r');
+	this->Diagnostics = NULL;
+	this->LineIndex = 0;
+	this->ParserLevel = 0;
+	this->bDryRun = false;
 }
 
 void T3DParser::ResetParser(const FString &Content)
 {
+	UDKIMPORT_SCOPE(ResetParser);
+	UDKIMPORT_LLM_SCOPE(Parser);
 	LineIndex = 0;
 	ParserLevel = 0;
 	Content.ParseIntoArray(Lines, TEXT("\n"), true);
+	INC_DWORD_STAT_BY(STAT_UDKImport_LinesParsed, Lines.Num());
+}
+
+void T3DParser::ResetParser(TArray<FString> &&InLines)
+{
+	LineIndex = 0;
+	ParserLevel = 0;
+	Lines = MoveTemp(InLines);
+	INC_DWORD_STAT_BY(STAT_UDKImport_LinesParsed, Lines.Num());
 }
 
 bool T3DParser::NextLine()
 {
 	if (LineIndex < Lines.Num())
 	{
-		int32 Start, End;
 		const FString &String = Lines[LineIndex];
-		Start = 0;
-		End = String.Len();
-
-		// Trimming
-		while (Start < End && IsWhitespace(String[Start]))
-		{
-			++Start;
-		}
-
-		while (End > Start && IsWhitespace(String[End-1]))
-		{
-			--End;
-		}
-
-		Line = String.Mid(Start, End - Start);
+		T3DCore::TSpan<TCHAR> Trimmed = T3DCore::Trim(*String, *String + String.Len());
+		Line = String.Mid(Trimmed.Begin - *String, Trimmed.Len());
 		++LineIndex;
 		return true;
 	}
@@ -80,16 +105,9 @@ void T3DParser::JumpToEnd()
 	int32 Level = 1;
 	while (NextLine())
 	{
-		if (Line.StartsWith(TEXT("Begin "), ESearchCase::CaseSensitive))
-		{
-			++Level;
-		}
-		else if (Line.StartsWith(TEXT("End "), ESearchCase::CaseSensitive))
-		{
-			--Level;
-			if (Level == 0)
-				break;
-		}
+		Level += T3DCore::LineDepthDelta(*Line, *Line + Line.Len());
+		if (Level == 0)
+			break;
 	}
 }
 
@@ -110,48 +128,10 @@ bool T3DParser::IsEndObject()
 
 bool T3DParser::GetOneValueAfter(const FString &Key, FString &Value, int32 maxindex)
 {
-	int32 start = Line.Find(Key, ESearchCase::CaseSensitive, ESearchDir::FromStart, 0);
-	if (start != -1 && start <= maxindex)
+	T3DCore::TSpan<TCHAR> Span;
+	if (T3DCore::GetOneValueAfter(*Line, *Line + Line.Len(), *Key, Key.Len(), Span, (size_t)FMath::Max(maxindex, 0)))
 	{
-		start += Key.Len();
-
-		const TCHAR * Buffer = *Line + start;
-		if (*Buffer == TCHAR('"'))
-		{
-			++start;
-			++Buffer;
-			bool Escaping = false;
-			while (*Buffer && (*Buffer != TCHAR('"') || Escaping))
-			{
-				if (Escaping)
-					Escaping = false;
-				else if (*Buffer == TCHAR('\\'))
-					Escaping = true;
-				++Buffer;
-			}
-		}
-		else if(*Buffer == TCHAR('('))
-		{
-			++Buffer;
-			int Level = 1;
-			while (*Buffer && Level != 0)
-			{
-				if (*Buffer == TCHAR('('))
-					++Level;
-				else if (*Buffer == TCHAR(')'))
-					--Level;
-				++Buffer;
-			}
-		}
-		else
-		{
-			while (*Buffer && *Buffer != TCHAR(' ') && *Buffer != TCHAR(',') && *Buffer != TCHAR(')'))
-			{
-				++Buffer;
-			}
-		}
-		Value = Line.Mid(start, Buffer - *Line - start);
-
+		Value = Line.Mid(Span.Begin - *Line, Span.Len());
 		return true;
 	}
 	return false;
@@ -170,6 +150,9 @@ void T3DParser::AddRequirement(const FString &UDKRequiredObjectName, UObjectDele
 
 void T3DParser::AddRequirement(const FRequirement &Requirement, UObjectDelegate Action)
 {
+	UDKIMPORT_SCOPE(AddRequirement);
+	UDKIMPORT_LLM_SCOPE(Requirements);
+	INC_DWORD_STAT(STAT_UDKImport_RequirementsAdded);
 	UObject ** pObject = FixedRequirements.Find(Requirement);
 	if (pObject != NULL)
 	{
@@ -180,12 +163,22 @@ void T3DParser::AddRequirement(const FRequirement &Requirement, UObjectDelegate
 	FString ObjectPath = GetPathToUAsset(Requirement.RelDirectory, Requirement.Name);
 	UObject * asset = NULL;
 
-	if (Requirement.Type == TEXT("StaticMesh"))
+	if (bDryRun)
+	{
+		// Looked up in the asset registry once every file is parsed
+	}
+	else if (Requirement.Type == TEXT("StaticMesh"))
+	{
+		INC_DWORD_STAT(STAT_UDKImport_SyncLoads);
 		asset = LoadObject<UStaticMesh>(NULL, *ObjectPath);
+	}
 	/*else if (Requirement.Type == TEXT("Material") || Requirement.Type == TEXT("DecalMaterial"))
 		asset = LoadObject<UMaterial>(NULL, *ObjectPath);*/
 	else if (Requirement.Type.StartsWith(TEXT("Texture")))
+	{
+		INC_DWORD_STAT(STAT_UDKImport_SyncLoads);
 		asset = LoadObject<UTexture>(NULL, *ObjectPath);
+	}
 
 	
 	TArray<UObjectDelegate> * pActions = Requirements.Find(Requirement);
@@ -217,11 +210,23 @@ void T3DParser::FixRequirement(const FString &UDKRequiredObjectName, UObject * O
 	FixRequirement(Requirement, Object);
 }
 
+void T3DParser::RemoveLastRequirementAction(const FRequirement &Requirement)
+{
+	// Fixed requirements run their action right away, nothing was queued
+	TArray<UObjectDelegate> * pActions = Requirements.Find(Requirement);
+	if (pActions != NULL && pActions->Num() > 0 && !FixedRequirements.Contains(Requirement))
+	{
+		pActions->Pop();
+	}
+}
+
 void T3DParser::FixRequirement(const FRequirement &Requirement, UObject * Object)
 {
+	UDKIMPORT_LLM_SCOPE(Requirements);
 	if (Object == NULL)
 		return;
 
+	INC_DWORD_STAT(STAT_UDKImport_RequirementsFixed);
 	FixedRequirements.Add(FRequirement(Requirement), Object);
 
 	TArray<UObjectDelegate> * pActions = Requirements.Find(Requirement);
@@ -258,12 +263,21 @@ bool T3DParser::FindRequirement(const FRequirement &Requirement, UObject * &Obje
 	return false;
 }
 
-void T3DParser::PrintMissingRequirements()
+void T3DParser::ReportMissingRequirements()
 {
 	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
 	{
 		const FRequirement &Requirement = Iter.Key();
-		UE_LOG(UDKImportPluginLog, Warning, TEXT("Missing requirements : %s"), *Requirement.Url);
+		const FString ObjectPath = GetPathToUAsset(Requirement.RelDirectory, Requirement.Name);
+		AddDiagnostic(FUDKImportDiagnostics::ESeverity::Warning, FUDKImportDiagnostics::ECode::MissingRequirement, ObjectPath, FString::Printf(TEXT("Failed to find %s '%s'"), *Requirement.Type, *ObjectPath));
+	}
+}
+
+void T3DParser::AddDiagnostic(FUDKImportDiagnostics::ESeverity::Type Severity, FUDKImportDiagnostics::ECode::Type Code, const FString &Asset, const FString &Message)
+{
+	if (Diagnostics != NULL)
+	{
+		Diagnostics->Add(Severity, Code, SourceFile, LineIndex, Asset, Message);
 	}
 }
 
@@ -285,36 +299,19 @@ bool T3DParser::ParseUDKRotation(const FString &InSourceString, FRotator &Rotato
 
 bool T3DParser::ParseFVector(const TCHAR* Stream, FVector& Value)
 {
-	Value = FVector::ZeroVector;
-
-	Value.X = FCString::Atof(Stream);
-	Stream = FCString::Strchr(Stream, ',');
-	if (!Stream)
-	{
-		return false;
-	}
-
-	Stream++;
-	Value.Y = FCString::Atof(Stream);
-	Stream = FCString::Strchr(Stream, ',');
-	if (!Stream)
-	{
-		return false;
-	}
-
-	Stream++;
-	Value.Z = FCString::Atof(Stream);
-
-	return true;
+	double X, Y, Z;
+	bool bSuccessful = T3DCore::ParseVector(Stream, X, Y, Z);
+	Value = FVector(X, Y, Z);
+	return bSuccessful;
 }
 
 bool T3DParser::IsProperty(FString &PropertyName, FString &Value)
 {
-	int32 Index;
-	if (Line.FindChar('=', Index) && Index > 0)
+	T3DCore::TSpan<TCHAR> NameSpan, ValueSpan;
+	if (T3DCore::IsProperty(*Line, *Line + Line.Len(), NameSpan, ValueSpan))
 	{
-		PropertyName = Line.Mid(0, Index);
-		Value = Line.Mid(Index + 1);
+		PropertyName = Line.Mid(0, NameSpan.Len());
+		Value = Line.Mid(ValueSpan.Begin - *Line, ValueSpan.Len());
 		return true;
 	}
 
@@ -383,44 +380,24 @@ bool T3DParser::IsActorProperty(AActor * Actor)
 
 void T3DParser::ParseRessourceUrl(const FString &Url, FString &relDirectory, FString &Name)
 {
-	int32 PackageIndex;
+	T3DCore::TSpan<TCHAR> PackageSpan, NameSpan;
+	bool bHasPackage;
+	T3DCore::SplitPackagePath(*Url, *Url + Url.Len(), PackageSpan, NameSpan, bHasPackage);
 
-	PackageIndex = Url.Find(".", ESearchCase::CaseSensitive, ESearchDir::FromEnd);
-
-	if (PackageIndex == -1)
-	{
-		relDirectory = this->RelDirectory;
-		Name = Url;
-	}
-	else
-	{
-		relDirectory = Url.Mid(0, PackageIndex);
-		Name = Url.Mid(PackageIndex + 1);
-	}
+	relDirectory = bHasPackage ? Url.Mid(0, PackageSpan.Len()) : this->RelDirectory;
+	Name = Url.Mid(NameSpan.Begin - *Url, NameSpan.Len());
 }
 
 bool T3DParser::ParseRessourceUrl(const FString &Url, FString &Type, FString &relDirectory, FString &Name)
 {
-	int32 Index, PackageIndex;
-
-	if (!Url.FindChar('\'', Index) || !Url.EndsWith(TEXT("'")))
+	T3DCore::TRessourceUrl<TCHAR> Parsed;
+	if (!T3DCore::ParseRessourceUrl(*Url, *Url + Url.Len(), Parsed))
 		return false;
 
-	Type = Url.Mid(0, Index);
-	++Index;
-	PackageIndex = Url.Find(".", ESearchCase::CaseSensitive, ESearchDir::FromEnd);
-
-	if (PackageIndex == -1)
-	{
-		// Package Name is the current Package
-		relDirectory = this->RelDirectory;
-		Name = Url.Mid(Index, Url.Len() - Index - 1);
-	}
-	else
-	{
-		relDirectory = Url.Mid(Index, PackageIndex - Index);
-		Name = Url.Mid(PackageIndex + 1, Url.Len() - PackageIndex - 2);
-	}
+	Type = Url.Mid(0, Parsed.Type.Len());
+	// Package Name is the current Package when omitted
+	relDirectory = Parsed.bHasPackage ? Url.Mid(Parsed.Package.Begin - *Url, Parsed.Package.Len()) : this->RelDirectory;
+	Name = Url.Mid(Parsed.Name.Begin - *Url, Parsed.Name.Len());
 
 	return true;
-}
+}
\ No newline at end of file
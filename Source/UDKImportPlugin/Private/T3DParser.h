@@ -3,16 +3,13 @@
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
 #include "Engine/EngineTypes.h"
+#include "UDKImportStats.h"
+#include "UDKImportDiagnostics.h"
 //#define LOCTEXT_NAMESPACE "UDKImportPlugin"
 
 DECLARE_LOG_CATEGORY_EXTERN(UDKImportPluginLog, Log, All);
 DECLARE_DELEGATE_OneParam(UObjectDelegate, UObject*);
 
-static void OpenMsgDialog(FString f)
-{
-	FMessageDialog::Open(EAppMsgType::Type::Ok, FText::FromString(f));
-}
-
 class T3DParser
 {
 public:
@@ -55,8 +52,6 @@ protected:
 
 	T3DParser(const FString &SourcePath, const FString &DestPath);
 
-	int32 StatusNumerator, StatusDenominator;
-
 	FString SourcePath, DestPath;
 
 	/// Ressources requirements
@@ -68,13 +63,23 @@ protected:
 	void AddRequirement(const FRequirement &Requirement, UObjectDelegate Action);
 	void FixRequirement(const FRequirement &Requirement, UObject * Object);
 	bool FindRequirement(const FRequirement &Requirement, UObject * &Object);
-	void PrintMissingRequirements();
+	/** Drop the action AddRequirement just queued for Requirement, the object it writes to is discarded */
+	void RemoveLastRequirementAction(const FRequirement &Requirement);
+	void ReportMissingRequirements();
+	/** Requirements are only recorded, dry runs resolve them against the asset registry instead of loading them */
+	bool bDryRun;
+
+	/// Diagnostics, shared by the level parser and its subparsers
+	FUDKImportDiagnostics * Diagnostics;
+	FString SourceFile;
+	void AddDiagnostic(FUDKImportDiagnostics::ESeverity::Type Severity, FUDKImportDiagnostics::ECode::Type Code, const FString &Asset, const FString &Message);
 
 	/// Line parsing
 	int32 LineIndex, ParserLevel;
 	TArray<FString> Lines;
 	FString Line, RelDirectory;
 	void ResetParser(const FString &Content);
+	void ResetParser(TArray<FString> &&InLines);
 	bool NextLine();
 	bool IgnoreSubs();
 	bool IgnoreSubObjects();
@@ -0,0 +1,155 @@
+#include "UDKImportBenchmarkCommandlet.h"
+#include "UDKImportPluginPrivatePCH.h"
+#include "FileHelpers.h"
+#include "ObjectTools.h"
+#include "AssetRegistryModule.h"
+#include "T3DCorpusGenerator.h"
+#include "T3DLevelParser.h"
+
+UUDKImportBenchmarkCommandlet::UUDKImportBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+struct FBenchmarkPhase
+{
+	FString Name;
+	double Seconds;
+	T3DLevelParser::FImportCounters Counters;
+	uint64 UsedPhysical;
+	uint64 PeakUsedPhysical;
+
+	/** InPeakUsedPhysical is the peak of this phase only, the process peak would carry over from earlier phases */
+	FBenchmarkPhase(const FString &InName, double InSeconds, const T3DLevelParser::FImportCounters &InCounters, uint64 InPeakUsedPhysical)
+		: Name(InName)
+		, Seconds(FMath::Max(InSeconds, 1e-6))
+		, Counters(InCounters)
+	{
+		UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+		PeakUsedPhysical = FMath::Max(InPeakUsedPhysical, UsedPhysical);
+	}
+
+	FString ToCsv() const
+	{
+		return FString::Printf(TEXT("%s,%f,%d,%lld,%lld,%lld,%d,%f,%f,%f,%llu,%llu\n"), *Name, Seconds, Counters.Files, Counters.Bytes, Counters.Lines, Counters.Expressions, Counters.Actors,
+			Counters.Files / Seconds, Counters.Lines / Seconds, Counters.Expressions / Seconds, UsedPhysical / 1024 / 1024, PeakUsedPhysical / 1024 / 1024);
+	}
+
+	void Log() const
+	{
+		UE_LOG(UDKImportPluginLog, Display, TEXT("%-10s %8.3fs  %8.1f files/s  %10.1f lines/s  %10.1f expressions/s  %6llu MB used  %6llu MB peak"), *Name, Seconds,
+			Counters.Files / Seconds, Counters.Lines / Seconds, Counters.Expressions / Seconds, UsedPhysical / 1024 / 1024, PeakUsedPhysical / 1024 / 1024);
+	}
+};
+
+int32 UUDKImportBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString CorpusPath, DestPath = TEXT("UDKImportBenchmark"), ReportPath;
+	if (!FParse::Value(*Params, TEXT("corpus="), CorpusPath))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Usage : -run=UDKImportBenchmark -corpus=<directory> [-generate] [-dest=<content directory>] [-keepassets] [-report=<file>]"));
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("dest="), DestPath);
+	FParse::Value(*Params, TEXT("report="), ReportPath);
+	CorpusPath = CorpusPath.Replace(_TEXT("\\"), _TEXT("/"));
+	CorpusPath.RemoveFromEnd("/");
+
+	TArray<FBenchmarkPhase> Phases;
+
+	// Imported assets are only there to be measured, they are deleted unless the destination held something before
+	const FString DestDirectory = FPaths::ProjectContentDir() / DestPath;
+	const bool bCleanDest = !IFileManager::Get().DirectoryExists(*DestDirectory) && !FParse::Param(*Params, TEXT("keepassets"));
+
+	if (FParse::Param(*Params, TEXT("generate")))
+	{
+		T3DCorpusGenerator::FSettings Settings;
+		FParse::Value(*Params, TEXT("packages="), Settings.Packages);
+		FParse::Value(*Params, TEXT("materials="), Settings.Materials);
+		FParse::Value(*Params, TEXT("expressions="), Settings.ExpressionsPerMaterial);
+		FParse::Value(*Params, TEXT("chains="), Settings.InstanceChains);
+		FParse::Value(*Params, TEXT("depth="), Settings.InstanceDepth);
+		FParse::Value(*Params, TEXT("actors="), Settings.StaticMeshActors);
+		FParse::Value(*Params, TEXT("brushes="), Settings.Brushes);
+		FParse::Value(*Params, TEXT("lights="), Settings.Lights);
+		FParse::Value(*Params, TEXT("seed="), Settings.Seed);
+
+		// Only a corpus written by an earlier run is replaced, never a directory holding anything else
+		static const TCHAR * CorpusMarker = TEXT("UDKImportBenchmark.corpus");
+		if (IFileManager::Get().DirectoryExists(*CorpusPath))
+		{
+			bool bEmpty = true;
+			IFileManager::Get().IterateDirectory(*CorpusPath, [&bEmpty](const TCHAR *, bool)
+			{
+				bEmpty = false;
+				return false;
+			});
+			if (!bEmpty && !FPaths::FileExists(CorpusPath / CorpusMarker))
+			{
+				UE_LOG(UDKImportPluginLog, Error, TEXT("%s is not empty and was not generated by this benchmark, pick another -corpus directory"), *CorpusPath);
+				return 1;
+			}
+			IFileManager::Get().DeleteDirectory(*CorpusPath, false, true);
+		}
+
+		double Start = FPlatformTime::Seconds();
+		T3DCorpusGenerator Generator(Settings);
+		if (!Generator.Generate(CorpusPath) || !FFileHelper::SaveStringToFile(FString(), *(CorpusPath / CorpusMarker)))
+			return 1;
+		Phases.Add(FBenchmarkPhase(TEXT("Generate"), FPlatformTime::Seconds() - Start, T3DLevelParser::FImportCounters(), Generator.GetPeakUsedPhysical()));
+	}
+
+	{
+		T3DLevelParser Parser(CorpusPath, DestPath);
+		double Start = FPlatformTime::Seconds();
+		Parser.ImportMaterial();
+		Phases.Add(FBenchmarkPhase(TEXT("Materials"), FPlatformTime::Seconds() - Start, Parser.Counters, Parser.GetPeakUsedPhysical()));
+	}
+
+	if (FPaths::FileExists(CorpusPath / TEXT("PersistentLevel.T3D")))
+	{
+		T3DLevelParser Parser(CorpusPath, DestPath);
+		Parser.SetWorld(UEditorLoadingAndSavingUtils::NewBlankMap(false));
+		double Start = FPlatformTime::Seconds();
+		Parser.ImportLevel();
+		Phases.Add(FBenchmarkPhase(TEXT("Level"), FPlatformTime::Seconds() - Start, Parser.Counters, Parser.GetPeakUsedPhysical()));
+	}
+
+	if (bCleanDest)
+	{
+		TArray<FAssetData> AssetDatas;
+		TArray<UObject*> Assets;
+		FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get().GetAssetsByPath(FName(*(TEXT("/Game/") + DestPath)), AssetDatas, true);
+		for (const FAssetData &AssetData : AssetDatas)
+		{
+			UObject * Asset = AssetData.FastGetAsset(false);
+			if (Asset)
+				Assets.Add(Asset);
+		}
+		if (Assets.Num() > 0)
+			ObjectTools::DeleteObjectsUnchecked(Assets);
+		IFileManager::Get().DeleteDirectory(*DestDirectory, false, true);
+	}
+	else
+	{
+		UE_LOG(UDKImportPluginLog, Display, TEXT("Benchmark assets left in /Game/%s"), *DestPath);
+	}
+
+	FString Report = TEXT("Phase,Seconds,Files,Bytes,Lines,Expressions,Actors,FilesPerSecond,LinesPerSecond,ExpressionsPerSecond,UsedMB,PeakMB\n");
+	for (const FBenchmarkPhase &Phase : Phases)
+	{
+		Phase.Log();
+		Report += Phase.ToCsv();
+	}
+
+	if (!ReportPath.IsEmpty() && !FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to write report : %s"), *ReportPath);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "UDKImportBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures import throughput against a synthetic T3D corpus.
+ *
+ * UE4Editor-Cmd.exe Project.uproject -run=UDKImportBenchmark -corpus=C:/Synthetic -generate [-materials=100 -expressions=20 -chains=100 -depth=3 -actors=1000 -brushes=50 -lights=100 -packages=4 -seed=0] [-report=Benchmark.csv] -unattended -nullrhi
+ *
+ * Each importer phase reports files/s, lines/s, expressions/s and memory usage.
+ */
+UCLASS()
+class UUDKImportBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UUDKImportBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
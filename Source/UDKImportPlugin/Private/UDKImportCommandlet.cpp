@@ -0,0 +1,158 @@
+#include "UDKImportCommandlet.h"
+#include "UDKImportPluginPrivatePCH.h"
+#include "FileHelpers.h"
+#include "SUDKImportScreen.h"
+#include "T3DLevelParser.h"
+#include "UDKImportShards.h"
+
+UUDKImportCommandlet::UUDKImportCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UUDKImportCommandlet::Main(const FString& Params)
+{
+	FString SourcePath, DestPath, Mode, SummaryPath, MapPath;
+	if (!FParse::Value(*Params, TEXT("source="), SourcePath) || !FParse::Value(*Params, TEXT("dest="), DestPath))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Usage : -run=UDKImport -source=<T3D directory> -dest=<content directory> [-mode=Material] [-summary=<file>] [-map=<map asset path>] [-bulk] [-dryrun] [-shards=<count>] [-shardtimeout=<minutes>] [-reportdir=<directory>]"));
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("mode="), Mode);
+	FParse::Value(*Params, TEXT("summary="), SummaryPath);
+	FParse::Value(*Params, TEXT("map="), MapPath);
+
+	SourcePath = SourcePath.Replace(_TEXT("\\"), _TEXT("/"));
+	SourcePath.RemoveFromEnd("/");
+	DestPath = DestPath.Replace(_TEXT("\\"), _TEXT("/"));
+	DestPath.RemoveFromEnd("/");
+	DestPath.RemoveFromStart("/");
+
+	EUDKImportMode::Type ImportMode = EUDKImportMode::Material;
+	if (Mode.Equals(TEXT("Level")) || Mode.Equals(TEXT("Map")))
+		ImportMode = EUDKImportMode::Map;
+	else if (Mode.Equals(TEXT("StaticMesh")))
+		ImportMode = EUDKImportMode::StaticMesh;
+	else if (Mode.Equals(TEXT("MaterialInstanceConstant")))
+		ImportMode = EUDKImportMode::MaterialInstanceConstant;
+	else if (!Mode.IsEmpty() && !Mode.Equals(TEXT("Material")))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unknown import mode : %s"), *Mode);
+		return 1;
+	}
+
+	if (ImportMode == EUDKImportMode::Map && MapPath.IsEmpty())
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Level import requires -map=<map asset path>"));
+		return 1;
+	}
+
+	if (FParse::Param(*Params, TEXT("shards")) || Params.Contains(TEXT("-shards=")))
+	{
+		if (ImportMode == EUDKImportMode::Map)
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Levels are imported into one map, -shards is ignored"));
+		}
+		else
+		{
+			int32 ShardCount = 0, ShardMemory = 4096, ShardTimeout = 240;
+			FParse::Value(*Params, TEXT("shardmemory="), ShardMemory);
+			FParse::Value(*Params, TEXT("shardtimeout="), ShardTimeout);
+			if (!FParse::Value(*Params, TEXT("shards="), ShardCount) || ShardCount <= 0)
+				ShardCount = FUDKImportShards::DefaultShardCount(ShardMemory);
+
+			FString ChildParams;
+			const bool bBulkImport = FParse::Param(*Params, TEXT("bulk"));
+			if (bBulkImport)
+				ChildParams += TEXT(" -bulk");
+			if (FParse::Param(*Params, TEXT("dryrun")))
+				ChildParams += TEXT(" -dryrun");
+			FUDKImportShards Shards(SourcePath, DestPath, Mode.IsEmpty() ? TEXT("Material") : Mode);
+			Shards.SetTimeout(ShardTimeout * 60.);
+			return Shards.Run(ShardCount, ChildParams, bBulkImport, SummaryPath);
+		}
+	}
+
+	T3DLevelParser Parser(SourcePath, DestPath);
+	FString ManifestPath;
+	if (FParse::Value(*Params, TEXT("manifest="), ManifestPath))
+	{
+		// Shard of a sharded import, see FUDKImportShards
+		TArray<FString> Files;
+		if (!FFileHelper::LoadFileToStringArray(Files, *ManifestPath))
+		{
+			UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to read manifest : %s"), *ManifestPath);
+			return 1;
+		}
+		Parser.SetShardFiles(Files);
+	}
+	FString ReportDirectory;
+	if (FParse::Value(*Params, TEXT("reportdir="), ReportDirectory))
+	{
+		Parser.SetReportDirectory(ReportDirectory);
+	}
+	// Nothing is left for the user to save, the import writes every package it touched
+	Parser.Settings.bSaveImportedPackages = true;
+	if (FParse::Param(*Params, TEXT("bulk")))
+	{
+		Parser.Settings.bBulkImport = true;
+	}
+	if (FParse::Param(*Params, TEXT("dryrun")))
+	{
+		Parser.Settings.bDryRun = true;
+	}
+	bool bFailed = false;
+	switch (ImportMode)
+	{
+	case EUDKImportMode::Map:
+	{
+		if (Parser.Settings.bDryRun)
+		{
+			// Nothing is spawned, no map to create
+			Parser.ImportLevel();
+			break;
+		}
+		UWorld * World = UEditorLoadingAndSavingUtils::NewBlankMap(false);
+		if (World == NULL)
+		{
+			UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to create a map to import into"));
+			return 1;
+		}
+		Parser.SetWorld(World);
+		Parser.ImportLevel();
+		if (!UEditorLoadingAndSavingUtils::SaveMap(World, MapPath))
+		{
+			UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to save map : %s"), *MapPath);
+			bFailed = true;
+		}
+		break;
+	}
+	case EUDKImportMode::StaticMesh:
+		Parser.ImportStaticMesh();
+		break;
+	case EUDKImportMode::Material:
+		Parser.ImportMaterial();
+		break;
+	case EUDKImportMode::MaterialInstanceConstant:
+		Parser.ImportMaterialInstanceConstant();
+		break;
+	}
+
+	if (!SummaryPath.IsEmpty() && !Parser.WriteSummary(SummaryPath))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to write summary : %s"), *SummaryPath);
+		return 1;
+	}
+
+	// Failed files and package saves are error diagnostics, shards report them through their exit code
+	const int32 Errors = Parser.ImportDiagnostics.Num(FUDKImportDiagnostics::ESeverity::Error);
+	if (Errors > 0)
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Import finished with %d errors"), Errors);
+		bFailed = true;
+	}
+	return bFailed ? 1 : 0;
+}
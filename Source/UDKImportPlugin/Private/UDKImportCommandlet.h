@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "UDKImportCommandlet.generated.h"
+
+/**
+ * Runs an import without the editor UI, for unattended batch runs.
+ *
+ * UE4Editor-Cmd.exe Project.uproject -run=UDKImport -source=C:/Export -dest=Original -mode=Material [-summary=Summary.json] -unattended -nullrhi
+ *
+ * Modes are Level, StaticMesh, Material and MaterialInstanceConstant. Level mode also requires -map=/Game/Path/MapName.
+ * -bulk keeps changes out of the transaction buffer, see FUDKImportSettings::bBulkImport.
+ * -shards=N splits the import across N editor processes, see FUDKImportShards. -shards=0 picks N from cores and memory.
+ */
+UCLASS()
+class UUDKImportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UUDKImportCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,146 @@
+#include "UDKImportDiagnostics.h"
+#include "UDKImportPluginPrivatePCH.h"
+#include "T3DParser.h"
+#include "Logging/MessageLog.h"
+#include "Misc/UObjectToken.h"
+
+const FName FUDKImportDiagnostics::MessageLogName(TEXT("UDKImport"));
+
+const TCHAR * FUDKImportDiagnostics::ESeverity::ToString(Type Severity)
+{
+	switch (Severity)
+	{
+	case Info: return TEXT("Info");
+	case Warning: return TEXT("Warning");
+	default: return TEXT("Error");
+	}
+}
+
+const TCHAR * FUDKImportDiagnostics::ECode::ToString(Type Code)
+{
+	switch (Code)
+	{
+	case UnreadableFile: return TEXT("UnreadableFile");
+	case UnsupportedClass: return TEXT("UnsupportedClass");
+	case UnsupportedExpression: return TEXT("UnsupportedExpression");
+	case UnknownExpressionClass: return TEXT("UnknownExpressionClass");
+	case MissingFunction: return TEXT("MissingFunction");
+	case MissingRequirement: return TEXT("MissingRequirement");
+	case ImportFailed: return TEXT("ImportFailed");
+	case SamplerBudget: return TEXT("SamplerBudget");
+	case SaveFailed: return TEXT("SaveFailed");
+	default: return TEXT("DryRun");
+	}
+}
+
+FUDKImportDiagnostics::FUDKImportDiagnostics(int32 ExpectedEntries)
+{
+	Entries.Reserve(ExpectedEntries);
+}
+
+void FUDKImportDiagnostics::Add(ESeverity::Type Severity, ECode::Type Code, const FString &SourceFile, int32 Line, const FString &Asset, const FString &Message)
+{
+	FScopeLock ScopeLock(&Lock);
+	FEntry &Entry = Entries[Entries.AddDefaulted()];
+	Entry.Severity = Severity;
+	Entry.Code = Code;
+	Entry.SourceFile = SourceFile;
+	Entry.Line = Line;
+	Entry.Asset = Asset;
+	Entry.Message = Message;
+}
+
+int32 FUDKImportDiagnostics::Num() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries.Num();
+}
+
+int32 FUDKImportDiagnostics::Num(ESeverity::Type Severity) const
+{
+	FScopeLock ScopeLock(&Lock);
+	int32 Count = 0;
+	for (const FEntry &Entry : Entries)
+	{
+		if (Entry.Severity == Severity)
+			++Count;
+	}
+	return Count;
+}
+
+TArray<FUDKImportDiagnostics::FEntry> FUDKImportDiagnostics::GetEntries() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Entries;
+}
+
+void FUDKImportDiagnostics::Report(const FText &Title) const
+{
+	const TArray<FEntry> Snapshot = GetEntries();
+
+	// Nobody looks at the message log of a commandlet
+	if (IsRunningCommandlet() || FApp::IsUnattended())
+	{
+		for (const FEntry &Entry : Snapshot)
+		{
+			if (Entry.Severity == ESeverity::Error)
+				UE_LOG(UDKImportPluginLog, Error, TEXT("[%s] %s (%s:%d)"), ECode::ToString(Entry.Code), *Entry.Message, *Entry.SourceFile, Entry.Line);
+			else if (Entry.Severity == ESeverity::Warning)
+				UE_LOG(UDKImportPluginLog, Warning, TEXT("[%s] %s (%s:%d)"), ECode::ToString(Entry.Code), *Entry.Message, *Entry.SourceFile, Entry.Line);
+			else
+				UE_LOG(UDKImportPluginLog, Log, TEXT("[%s] %s (%s:%d)"), ECode::ToString(Entry.Code), *Entry.Message, *Entry.SourceFile, Entry.Line);
+		}
+		return;
+	}
+
+	FMessageLog Log(MessageLogName);
+	Log.NewPage(Title);
+	for (const FEntry &Entry : Snapshot)
+	{
+		const EMessageSeverity::Type Severity = Entry.Severity == ESeverity::Error ? EMessageSeverity::Error : (Entry.Severity == ESeverity::Warning ? EMessageSeverity::Warning : EMessageSeverity::Info);
+		TSharedRef<FTokenizedMessage> Message = Log.Message(Severity, FText::FromString(Entry.Message));
+		if (!Entry.Asset.IsEmpty())
+		{
+			Message->AddToken(FAssetNameToken::Create(Entry.Asset));
+		}
+		if (!Entry.SourceFile.IsEmpty())
+		{
+			Message->AddToken(FTextToken::Create(FText::FromString(FString::Printf(TEXT("%s:%d"), *Entry.SourceFile, Entry.Line))));
+		}
+	}
+	if (Snapshot.Num() > 0)
+	{
+		Log.Notify(Title, EMessageSeverity::Warning, true);
+	}
+}
+
+void FUDKImportDiagnostics::WriteEntries(TJsonWriter<> &Writer, const FString &Identifier) const
+{
+	const TArray<FEntry> Snapshot = GetEntries();
+
+	Writer.WriteArrayStart(Identifier);
+	for (const FEntry &Entry : Snapshot)
+	{
+		Writer.WriteObjectStart();
+		Writer.WriteValue(TEXT("severity"), ESeverity::ToString(Entry.Severity));
+		Writer.WriteValue(TEXT("code"), ECode::ToString(Entry.Code));
+		Writer.WriteValue(TEXT("file"), Entry.SourceFile);
+		Writer.WriteValue(TEXT("line"), Entry.Line);
+		Writer.WriteValue(TEXT("asset"), Entry.Asset);
+		Writer.WriteValue(TEXT("message"), Entry.Message);
+		Writer.WriteObjectEnd();
+	}
+	Writer.WriteArrayEnd();
+}
+
+bool FUDKImportDiagnostics::WriteJson(const FString &FileName) const
+{
+	FString Json;
+	TSharedRef<TJsonWriter<> > Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+	WriteEntries(*Writer, TEXT("diagnostics"));
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	return FFileHelper::SaveStringToFile(Json, *FileName);
+}
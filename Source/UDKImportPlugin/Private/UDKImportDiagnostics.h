@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/JsonWriter.h"
+
+/**
+ * Problems found by an import, collected instead of stopping it.
+ *
+ * Any thread may add entries. Once the import is done they are sent to the "UDK Import" message log
+ * (or to the output log when unattended) and written to a JSON file for tools.
+ */
+class FUDKImportDiagnostics
+{
+public:
+	struct ESeverity
+	{
+		enum Type
+		{
+			Info,
+			Warning,
+			Error
+		};
+
+		static const TCHAR * ToString(Type Severity);
+	};
+
+	/** Stable identifiers, part of the machine readable report */
+	struct ECode
+	{
+		enum Type
+		{
+			UnreadableFile,
+			UnsupportedClass,
+			UnsupportedExpression,
+			UnknownExpressionClass,
+			MissingFunction,
+			MissingRequirement,
+			ImportFailed,
+			SamplerBudget,
+			SaveFailed,
+			DryRun
+		};
+
+		static const TCHAR * ToString(Type Code);
+	};
+
+	struct FEntry
+	{
+		ESeverity::Type Severity;
+		ECode::Type Code;
+		FString SourceFile;
+		int32 Line;
+		FString Asset;
+		FString Message;
+	};
+
+	static const FName MessageLogName;
+
+	FUDKImportDiagnostics(int32 ExpectedEntries = 256);
+
+	void Add(ESeverity::Type Severity, ECode::Type Code, const FString &SourceFile, int32 Line, const FString &Asset, const FString &Message);
+	int32 Num() const;
+	int32 Num(ESeverity::Type Severity) const;
+	TArray<FEntry> GetEntries() const;
+
+	/** Publish every entry without blocking, through the message log and a notification */
+	void Report(const FText &Title) const;
+
+	/** Entries as an array of objects named Identifier */
+	void WriteEntries(TJsonWriter<> &Writer, const FString &Identifier) const;
+	bool WriteJson(const FString &FileName) const;
+
+private:
+	mutable FCriticalSection Lock;
+	TArray<FEntry> Entries;
+};
\ No newline at end of file
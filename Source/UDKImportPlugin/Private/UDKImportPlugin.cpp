@@ -4,6 +4,8 @@
 #include "UDKImportPluginEdMode.h"
 #include "LevelEditor.h"
 #include "SUDKImportScreen.h"
+#include "MessageLogModule.h"
+#include "UDKImportDiagnostics.h"
 
 #define LOCTEXT_NAMESPACE "FUDKImportPluginModule"
 
@@ -20,6 +22,10 @@ void FUDKImportPluginModule::StartupModule()
 		MainMenuExtender->AddMenuExtension("FileProject", EExtensionHook::After, NULL, FMenuExtensionDelegate::CreateRaw(this, &FUDKImportPluginModule::AddSummonUDKImportMenuExtension));
 		FLevelEditorModule& LevelEditorModule = FModuleManager::LoadModuleChecked<FLevelEditorModule>("LevelEditor");
 		LevelEditorModule.GetMenuExtensibilityManager()->AddExtender(MainMenuExtender);
+
+		// Import problems are listed there once an import is done
+		FMessageLogModule& MessageLogModule = FModuleManager::LoadModuleChecked<FMessageLogModule>("MessageLog");
+		MessageLogModule.RegisterLogListing(FUDKImportDiagnostics::MessageLogName, LOCTEXT("UDKImportMessageLog", "UDK Import"));
 	}
 }
 
@@ -54,6 +60,11 @@ void FUDKImportPluginModule::ShutdownModule()
 {
 	// Unregister the tab spawner
 	FGlobalTabmanager::Get()->UnregisterTabSpawner(UDKImportPluginTabName);
+	if (FModuleManager::Get().IsModuleLoaded("MessageLog"))
+	{
+		FMessageLogModule& MessageLogModule = FModuleManager::GetModuleChecked<FMessageLogModule>("MessageLog");
+		MessageLogModule.UnregisterLogListing(FUDKImportDiagnostics::MessageLogName);
+	}
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
 	FEditorModeRegistry::Get().UnregisterMode(FUDKImportPluginEdMode::EM_UDKImportPluginEdModeId);
@@ -0,0 +1,49 @@
+#include "UDKImportSettings.h"
+#include "UDKImportPluginPrivatePCH.h"
+
+static const TCHAR * UDKImportSettingsSection = TEXT("UDKImportPlugin");
+
+FUDKImportSettings::FUDKImportSettings()
+	: MaxMaterialSamplers(16)
+	, PrefetchFiles(8)
+	, TickBudget(0.02f)
+	, bBulkImport(false)
+	, bSaveImportedPackages(true)
+	, bDryRun(false)
+	, bFlattenInstanceChains(false)
+	, bConvertBrushes(false)
+	, BrushCellSize(4096.f)
+	, bSetupHLOD(false)
+	, HLODClusterSize(20000.f)
+	, ShadersPerMaterialEstimate(100)
+{
+	FunctionSubstitutions.Add(TEXT("MaterialExpressionLightVector"), TEXT("/Game/LightVectorProxy.LightVectorProxy"));
+	FunctionSubstitutions.Add(TEXT("MaterialExpressionFlipBookSample"), TEXT("/Engine/Functions/Engine_MaterialFunctions02/Texturing/FlipBook.FlipBook"));
+}
+
+void FUDKImportSettings::LoadConfig()
+{
+	GConfig->GetInt(UDKImportSettingsSection, TEXT("MaxMaterialSamplers"), MaxMaterialSamplers, GEditorPerProjectIni);
+	GConfig->GetInt(UDKImportSettingsSection, TEXT("PrefetchFiles"), PrefetchFiles, GEditorPerProjectIni);
+	GConfig->GetFloat(UDKImportSettingsSection, TEXT("TickBudget"), TickBudget, GEditorPerProjectIni);
+	GConfig->GetBool(UDKImportSettingsSection, TEXT("BulkImport"), bBulkImport, GEditorPerProjectIni);
+	GConfig->GetBool(UDKImportSettingsSection, TEXT("SaveImportedPackages"), bSaveImportedPackages, GEditorPerProjectIni);
+	GConfig->GetBool(UDKImportSettingsSection, TEXT("DryRun"), bDryRun, GEditorPerProjectIni);
+	GConfig->GetBool(UDKImportSettingsSection, TEXT("FlattenInstanceChains"), bFlattenInstanceChains, GEditorPerProjectIni);
+	GConfig->GetBool(UDKImportSettingsSection, TEXT("ConvertBrushes"), bConvertBrushes, GEditorPerProjectIni);
+	GConfig->GetFloat(UDKImportSettingsSection, TEXT("BrushCellSize"), BrushCellSize, GEditorPerProjectIni);
+	GConfig->GetBool(UDKImportSettingsSection, TEXT("SetupHLOD"), bSetupHLOD, GEditorPerProjectIni);
+	GConfig->GetFloat(UDKImportSettingsSection, TEXT("HLODClusterSize"), HLODClusterSize, GEditorPerProjectIni);
+	GConfig->GetInt(UDKImportSettingsSection, TEXT("ShadersPerMaterialEstimate"), ShadersPerMaterialEstimate, GEditorPerProjectIni);
+
+	TArray<FString> Substitutions;
+	GConfig->GetArray(UDKImportSettingsSection, TEXT("FunctionSubstitutions"), Substitutions, GEditorPerProjectIni);
+	for (const FString &Substitution : Substitutions)
+	{
+		FString ExpressionClass, FunctionPath;
+		if (Substitution.Split(TEXT("="), &ExpressionClass, &FunctionPath))
+		{
+			FunctionSubstitutions.Add(ExpressionClass.TrimStartAndEnd(), FunctionPath.TrimStartAndEnd());
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Import options shared by every parser of an import run.
+ * Values are read from the [UDKImportPlugin] section of the editor per project ini.
+ */
+struct FUDKImportSettings
+{
+	/** Materials sampling more distinct textures than this are moved to shared samplers */
+	int32 MaxMaterialSamplers;
+
+	/**
+	 * UDK expression class -> object path of the material function replacing it.
+	 * Extended from the ini with entries like +FunctionSubstitutions=MaterialExpressionLightVector=/Game/LightVectorProxy.LightVectorProxy
+	 */
+	TMap<FString, FString> FunctionSubstitutions;
+
+	/** T3D files read ahead on worker threads while the game thread imports the current one */
+	int32 PrefetchFiles;
+
+	/** Game thread time given to the import every editor tick, in seconds */
+	float TickBudget;
+
+	/**
+	 * Skip transaction recording for the whole import, commandlets clear the undo history once it is done.
+	 * Meant for large batches, memory otherwise grows with every modified asset.
+	 */
+	bool bBulkImport;
+
+	/** Save every package written by the import once it is done */
+	bool bSaveImportedPackages;
+
+	/**
+	 * Parse the sources and resolve their references against the asset registry, without creating,
+	 * compiling or saving anything. The results go to Saved/UDKImport/DryRun.json.
+	 */
+	bool bDryRun;
+
+	/**
+	 * Parent imported instances directly to the material at the end of their instance chain, with the
+	 * parameters overridden along the chain merged in, the closest override winning.
+	 */
+	bool bFlattenInstanceChains;
+
+	/**
+	 * Replace imported brushes by static meshes once the level is imported. The CSG is evaluated once,
+	 * its surfaces are cut into cells of BrushCellSize units, with one mesh per cell and one section per material.
+	 */
+	bool bConvertBrushes;
+	float BrushCellSize;
+
+	/** Enable HLOD on imported levels and cluster their static mesh actors on a grid of HLODClusterSize units */
+	bool bSetupHLOD;
+	float HLODClusterSize;
+
+	/** Shaders compiled for one material or one static permutation, used by dry runs to estimate the shader count */
+	int32 ShadersPerMaterialEstimate;
+
+	FUDKImportSettings();
+
+	/** Override defaults with the values found in the editor ini */
+	void LoadConfig();
+};
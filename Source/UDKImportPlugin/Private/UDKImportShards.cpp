@@ -0,0 +1,292 @@
+#include "UDKImportShards.h"
+#include "UDKImportPluginPrivatePCH.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "T3DLevelParser.h"
+
+FUDKImportShards::FUDKImportShards(const FString &InSourcePath, const FString &InDestPath, const FString &InMode)
+	: SourcePath(InSourcePath)
+	, DestPath(InDestPath)
+	, Mode(InMode)
+	, TimeoutSeconds(0.)
+{
+	WorkPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("UDKImport") / TEXT("Shards"));
+}
+
+void FUDKImportShards::SetTimeout(double InTimeoutSeconds)
+{
+	TimeoutSeconds = InTimeoutSeconds;
+}
+
+int32 FUDKImportShards::DefaultShardCount(int32 MemoryPerShardMB)
+{
+	const uint64 TotalPhysicalMB = FPlatformMemory::GetConstants().TotalPhysical / 1024 / 1024;
+	const int32 ByMemory = (int32)(TotalPhysicalMB / FMath::Max(MemoryPerShardMB, 1));
+	return FMath::Max(1, FMath::Min(FPlatformMisc::NumberOfCores(), ByMemory));
+}
+
+void FUDKImportShards::SplitSourceTree(int32 ShardCount)
+{
+	TArray<FString> FileNames;
+	IFileManager::Get().FindFilesRecursive(FileNames, *SourcePath, _T("*.T3D"), true, false);
+
+	// Files of one UDK package stay together, most of their references are local
+	TMap<FString, TArray<FString> > Packages;
+	TMap<FString, int64> PackageBytes;
+	for (const FString &FileName : FileNames)
+	{
+		FString RelPath = FileName;
+		RelPath.RemoveFromStart(SourcePath + TEXT("/"), ESearchCase::IgnoreCase);
+		FString Package;
+		if (!RelPath.Split(TEXT("/"), &Package, NULL))
+			Package = FString();
+
+		Packages.FindOrAdd(Package).Add(RelPath);
+		PackageBytes.FindOrAdd(Package) += FMath::Max<int64>(IFileManager::Get().FileSize(*FileName), 0);
+	}
+
+	// Largest packages first, each to the lightest shard
+	TArray<FString> PackageNames;
+	Packages.GetKeys(PackageNames);
+	PackageNames.Sort([&PackageBytes](const FString &A, const FString &B)
+	{
+		return PackageBytes[A] > PackageBytes[B];
+	});
+
+	Shards.SetNum(FMath::Clamp(ShardCount, 1, FMath::Max(PackageNames.Num(), 1)));
+	for (FShard &Shard : Shards)
+	{
+		Shard.Bytes = 0;
+		Shard.ReturnCode = 0;
+		Shard.Seconds = 0.;
+	}
+	for (const FString &Package : PackageNames)
+	{
+		FShard * Lightest = &Shards[0];
+		for (FShard &Shard : Shards)
+		{
+			if (Shard.Bytes < Lightest->Bytes)
+				Lightest = &Shard;
+		}
+		Lightest->Files.Append(Packages[Package]);
+		Lightest->Bytes += PackageBytes[Package];
+	}
+	Shards.RemoveAll([](const FShard &Shard)
+	{
+		return Shard.Files.Num() == 0;
+	});
+}
+
+bool FUDKImportShards::LaunchShard(int32 Index, const FString &ChildParams)
+{
+	FShard &Shard = Shards[Index];
+	Shard.ManifestPath = WorkPath / FString::Printf(TEXT("Shard%d.txt"), Index);
+	Shard.SummaryPath = WorkPath / FString::Printf(TEXT("Shard%d.json"), Index);
+	// Every shard writes its reports to its own directory, they would overwrite each other in Saved/UDKImport
+	Shard.ReportPath = WorkPath / FString::Printf(TEXT("Shard%d"), Index);
+	const FString LogPath = WorkPath / FString::Printf(TEXT("Shard%d.log"), Index);
+	IFileManager::Get().Delete(*Shard.SummaryPath, false, true, true);
+	if (!FFileHelper::SaveStringArrayToFile(Shard.Files, *Shard.ManifestPath))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to write shard manifest : %s"), *Shard.ManifestPath);
+		return false;
+	}
+
+	const FString ProjectPath = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	const FString Params = FString::Printf(TEXT("\"%s\" -run=UDKImport -source=\"%s\" -dest=\"%s\" -mode=%s -manifest=\"%s\" -summary=\"%s\" -reportdir=\"%s\" -abslog=\"%s\" -unattended -nullrhi -nosplash -nopause %s"),
+		*ProjectPath, *SourcePath, *DestPath, *Mode, *Shard.ManifestPath, *Shard.SummaryPath, *Shard.ReportPath, *LogPath, *ChildParams);
+
+	Shard.Seconds = FPlatformTime::Seconds();
+	Shard.Process = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Params, false, true, true, NULL, 0, NULL, NULL);
+	if (!Shard.Process.IsValid())
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to start shard %d"), Index);
+		return false;
+	}
+
+	UE_LOG(UDKImportPluginLog, Display, TEXT("Shard %d : %d files, %lld KB, log in %s"), Index, Shard.Files.Num(), Shard.Bytes / 1024, *LogPath);
+	return true;
+}
+
+void FUDKImportShards::WaitForShards()
+{
+	int32 Running = Shards.Num();
+	while (Running > 0)
+	{
+		FPlatformProcess::Sleep(0.5f);
+		Running = 0;
+		for (int32 Index = 0; Index < Shards.Num(); ++Index)
+		{
+			FShard &Shard = Shards[Index];
+			if (!Shard.Process.IsValid())
+				continue;
+
+			if (FPlatformProcess::IsProcRunning(Shard.Process))
+			{
+				if (TimeoutSeconds <= 0. || FPlatformTime::Seconds() - Shard.Seconds < TimeoutSeconds)
+				{
+					++Running;
+					continue;
+				}
+
+				// A hung shard would hang the whole import, its files are reported as failed instead
+				UE_LOG(UDKImportPluginLog, Error, TEXT("Shard %d still running after %.0fs, killed"), Index, TimeoutSeconds);
+				FPlatformProcess::TerminateProc(Shard.Process, true);
+				FPlatformProcess::CloseProc(Shard.Process);
+				Shard.ReturnCode = -1;
+				Shard.Seconds = FPlatformTime::Seconds() - Shard.Seconds;
+				continue;
+			}
+
+			FPlatformProcess::GetProcReturnCode(Shard.Process, &Shard.ReturnCode);
+			FPlatformProcess::CloseProc(Shard.Process);
+			Shard.Seconds = FPlatformTime::Seconds() - Shard.Seconds;
+			UE_LOG(UDKImportPluginLog, Display, TEXT("Shard %d done in %.1fs, exit code %d"), Index, Shard.Seconds, Shard.ReturnCode);
+		}
+	}
+}
+
+FString FUDKImportShards::RequirementUrlToPackage(const FString &Url) const
+{
+	// Type'Package.Group.Name' -> /Game/Dest/Package/Group/Name
+	FString Path;
+	if (!Url.Split(TEXT("'"), NULL, &Path))
+		return FString();
+	Path.RemoveFromEnd(TEXT("'"));
+	return TEXT("/Game") / DestPath / Path.Replace(TEXT("."), TEXT("/"));
+}
+
+static void AppendArray(const TSharedPtr<FJsonObject> &Object, const TCHAR * Field, TArray<TSharedPtr<FJsonValue> > &Values)
+{
+	const TArray<TSharedPtr<FJsonValue> > * Array;
+	if (Object->TryGetArrayField(Field, Array))
+	{
+		Values.Append(*Array);
+	}
+}
+
+bool FUDKImportShards::MergeSummary(const FString &FileName, TMap<FString, int32> &Imported, int32 &Saved, TArray<TSharedPtr<FJsonValue> > &SaveFailures, TArray<TSharedPtr<FJsonValue> > &Messages, TSet<FString> &Missing, TSet<FString> &Incomplete) const
+{
+	FString Json;
+	TSharedPtr<FJsonObject> Summary;
+	if (!FFileHelper::LoadFileToString(Json, *FileName) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Summary) || !Summary.IsValid())
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to read shard summary : %s"), *FileName);
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject> * ImportedObject;
+	if (Summary->TryGetObjectField(TEXT("imported"), ImportedObject))
+	{
+		for (auto Iter = (*ImportedObject)->Values.CreateConstIterator(); Iter; ++Iter)
+		{
+			Imported.FindOrAdd(Iter.Key()) += (int32)Iter.Value()->AsNumber();
+		}
+	}
+	Saved += (int32)Summary->GetNumberField(TEXT("saved"));
+	AppendArray(Summary, TEXT("saveFailures"), SaveFailures);
+	AppendArray(Summary, TEXT("messages"), Messages);
+
+	TArray<FString> Strings;
+	if (Summary->TryGetStringArrayField(TEXT("missing"), Strings))
+		Missing.Append(Strings);
+	if (Summary->TryGetStringArrayField(TEXT("incomplete"), Strings))
+		Incomplete.Append(Strings);
+	return true;
+}
+
+int32 FUDKImportShards::Run(int32 ShardCount, const FString &ChildParams, bool bBulkImport, const FString &SummaryPath)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	SplitSourceTree(ShardCount);
+	UE_LOG(UDKImportPluginLog, Display, TEXT("Importing %s with %d shards"), *SourcePath, Shards.Num());
+
+	int32 ExitCode = 0;
+	for (int32 Index = 0; Index < Shards.Num(); ++Index)
+	{
+		if (!LaunchShard(Index, ChildParams))
+			ExitCode = 1;
+	}
+	WaitForShards();
+
+	TMap<FString, int32> Imported;
+	int32 Saved = 0;
+	TArray<TSharedPtr<FJsonValue> > SaveFailures, Messages, ShardValues;
+	TSet<FString> Missing, Incomplete;
+	for (int32 Index = 0; Index < Shards.Num(); ++Index)
+	{
+		const FShard &Shard = Shards[Index];
+		// A shard with errors still wrote its summary, what it imported is merged all the same
+		if (!MergeSummary(Shard.SummaryPath, Imported, Saved, SaveFailures, Messages, Missing, Incomplete) || Shard.ReturnCode != 0)
+			ExitCode = 1;
+
+		TSharedPtr<FJsonObject> ShardObject = MakeShared<FJsonObject>();
+		ShardObject->SetNumberField(TEXT("files"), Shard.Files.Num());
+		ShardObject->SetNumberField(TEXT("bytes"), Shard.Bytes);
+		ShardObject->SetNumberField(TEXT("seconds"), Shard.Seconds);
+		ShardObject->SetNumberField(TEXT("exitCode"), Shard.ReturnCode);
+		ShardValues.Add(MakeShared<FJsonValueObject>(ShardObject));
+	}
+
+	// Every shard saved its assets, instances left without parent can be linked to them now
+	if (Incomplete.Num() > 0 && !ChildParams.Contains(TEXT("-dryrun")))
+	{
+		UE_LOG(UDKImportPluginLog, Display, TEXT("Final pass : %d instances referencing other shards"), Incomplete.Num());
+		T3DLevelParser Parser(SourcePath, DestPath);
+		Parser.Settings.bSaveImportedPackages = true;
+		Parser.Settings.bBulkImport = bBulkImport;
+		Parser.SetShardFiles(Incomplete.Array());
+		Parser.SetReportDirectory(WorkPath / TEXT("Final"));
+		Parser.ImportMaterialInstanceConstant();
+
+		const FString FinalSummaryPath = WorkPath / TEXT("Final.json");
+		TMap<FString, int32> Reimported;
+		Incomplete.Reset();
+		if (!Parser.WriteSummary(FinalSummaryPath) || !MergeSummary(FinalSummaryPath, Reimported, Saved, SaveFailures, Messages, Missing, Incomplete))
+			ExitCode = 1;
+		if (Parser.ImportDiagnostics.Num(FUDKImportDiagnostics::ESeverity::Error) > 0)
+			ExitCode = 1;
+	}
+
+	// References to another shard are only missing if nobody wrote them
+	TArray<TSharedPtr<FJsonValue> > MissingValues;
+	for (const FString &Url : Missing)
+	{
+		const FString Package = RequirementUrlToPackage(Url);
+		if (Package.IsEmpty() || !FPackageName::DoesPackageExist(Package))
+			MissingValues.Add(MakeShared<FJsonValueString>(Url));
+	}
+	TArray<TSharedPtr<FJsonValue> > IncompleteValues;
+	for (const FString &File : Incomplete)
+	{
+		IncompleteValues.Add(MakeShared<FJsonValueString>(File));
+	}
+
+	UE_LOG(UDKImportPluginLog, Display, TEXT("Sharded import done in %.1fs, %d packages saved, %d missing references"), FPlatformTime::Seconds() - StartTime, Saved, MissingValues.Num());
+	if (SummaryPath.IsEmpty())
+		return ExitCode;
+
+	TSharedRef<FJsonObject> Summary = MakeShared<FJsonObject>();
+	Summary->SetStringField(TEXT("source"), SourcePath);
+	Summary->SetStringField(TEXT("destination"), DestPath);
+	TSharedRef<FJsonObject> ImportedObject = MakeShared<FJsonObject>();
+	for (auto Iter = Imported.CreateConstIterator(); Iter; ++Iter)
+	{
+		ImportedObject->SetNumberField(Iter.Key(), Iter.Value());
+	}
+	Summary->SetObjectField(TEXT("imported"), ImportedObject);
+	Summary->SetNumberField(TEXT("saved"), Saved);
+	Summary->SetArrayField(TEXT("saveFailures"), SaveFailures);
+	Summary->SetArrayField(TEXT("missing"), MissingValues);
+	Summary->SetArrayField(TEXT("incomplete"), IncompleteValues);
+	Summary->SetArrayField(TEXT("messages"), Messages);
+	Summary->SetArrayField(TEXT("shards"), ShardValues);
+
+	FString Json;
+	if (!FJsonSerializer::Serialize(Summary, TJsonWriterFactory<>::Create(&Json)) || !FFileHelper::SaveStringToFile(Json, *SummaryPath))
+	{
+		UE_LOG(UDKImportPluginLog, Error, TEXT("Unable to write summary : %s"), *SummaryPath);
+		return 1;
+	}
+	return ExitCode;
+}
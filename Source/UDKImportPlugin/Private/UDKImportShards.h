@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+
+/**
+ * Splits an unattended import across several editor processes on the same machine.
+ *
+ * The source tree is split by UDK package directory, each shard imports its files from a manifest in its own
+ * headless editor. Shard summaries are then merged, and instances whose parent was written by another shard
+ * are imported again in a final pass, once every shard has saved its assets.
+ */
+class FUDKImportShards
+{
+public:
+	FUDKImportShards(const FString &InSourcePath, const FString &InDestPath, const FString &InMode);
+
+	/** As many shards as the machine has cores, as long as each one gets MemoryPerShardMB of physical memory */
+	static int32 DefaultShardCount(int32 MemoryPerShardMB);
+
+	/** Shards still running after TimeoutSeconds are killed and count as failed, 0 waits forever */
+	void SetTimeout(double InTimeoutSeconds);
+
+	/** Import with up to ShardCount processes, ChildParams are passed to every shard. Returns the commandlet exit code */
+	int32 Run(int32 ShardCount, const FString &ChildParams, bool bBulkImport, const FString &SummaryPath);
+
+private:
+	struct FShard
+	{
+		TArray<FString> Files;
+		int64 Bytes;
+		FString ManifestPath;
+		FString SummaryPath;
+		FString ReportPath;
+		FProcHandle Process;
+		int32 ReturnCode;
+		double Seconds;
+	};
+
+	FString SourcePath, DestPath, Mode, WorkPath;
+	double TimeoutSeconds;
+	TArray<FShard> Shards;
+
+	void SplitSourceTree(int32 ShardCount);
+	bool LaunchShard(int32 Index, const FString &ChildParams);
+	void WaitForShards();
+	bool MergeSummary(const FString &FileName, TMap<FString, int32> &Imported, int32 &Saved, TArray<TSharedPtr<FJsonValue> > &SaveFailures, TArray<TSharedPtr<FJsonValue> > &Messages, TSet<FString> &Missing, TSet<FString> &Incomplete) const;
+	FString RequirementUrlToPackage(const FString &Url) const;
+};
\ No newline at end of file
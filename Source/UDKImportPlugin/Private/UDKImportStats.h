@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "HAL/LowLevelMemStats.h"
+
+DECLARE_STATS_GROUP(TEXT("UDK Import"), STATGROUP_UDKImport, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ResetParser"), STAT_UDKImport_ResetParser, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ImportMaterial"), STAT_UDKImport_ImportMaterial, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ImportMaterialExpression"), STAT_UDKImport_ImportMaterialExpression, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ImportMaterialInstanceConstant"), STAT_UDKImport_ImportMaterialInstanceConstant, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AddRequirement"), STAT_UDKImport_AddRequirement, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ResolveRequirements"), STAT_UDKImport_ResolveRequirements, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PostEditChangeFor"), STAT_UDKImport_PostEditChangeFor, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ImportLevelInternal"), STAT_UDKImport_ImportLevelInternal, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ImportBrush"), STAT_UDKImport_ImportBrush, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ImportStaticMeshActor"), STAT_UDKImport_ImportStaticMeshActor, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ImportPointLight"), STAT_UDKImport_ImportPointLight, STATGROUP_UDKImport, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ImportSpotLight"), STAT_UDKImport_ImportSpotLight, STATGROUP_UDKImport, );
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Lines parsed"), STAT_UDKImport_LinesParsed, STATGROUP_UDKImport, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Requirements added"), STAT_UDKImport_RequirementsAdded, STATGROUP_UDKImport, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Requirements fixed"), STAT_UDKImport_RequirementsFixed, STATGROUP_UDKImport, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Synchronous loads"), STAT_UDKImport_SyncLoads, STATGROUP_UDKImport, );
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Parser buffers"), STAT_UDKImport_ParserMemory, STATGROUP_UDKImport, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Requirement maps"), STAT_UDKImport_RequirementMemory, STATGROUP_UDKImport, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Import caches"), STAT_UDKImport_CacheMemory, STATGROUP_UDKImport, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pending delegates"), STAT_UDKImport_PendingDelegates, STATGROUP_UDKImport, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Created objects"), STAT_UDKImport_CreatedObjects, STATGROUP_UDKImport, );
+
+/** Low level memory tracker tags, one per importer subsystem */
+#if defined(LLM_STAT_TAGS_ENABLED) && LLM_STAT_TAGS_ENABLED
+#define UDKIMPORT_LLM_ENABLED 1
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("UDKImport Parser"), STAT_UDKImportLLM_Parser, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("UDKImport Requirements"), STAT_UDKImportLLM_Requirements, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("UDKImport Assets"), STAT_UDKImportLLM_Assets, STATGROUP_LLMFULL, );
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("UDKImport Level"), STAT_UDKImportLLM_Level, STATGROUP_LLMFULL, );
+#define UDKIMPORT_LLM_SCOPE(Name) LLM_SCOPED_TAG_WITH_STAT(STAT_UDKImportLLM_##Name, ELLMTracker::Default)
+#else
+#define UDKIMPORT_LLM_ENABLED 0
+#define UDKIMPORT_LLM_SCOPE(Name)
+#endif
+
+/** Times a scope in the UDKImport stats group and as a CPU event in Unreal Insights */
+#define UDKIMPORT_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_UDKImport_##Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(UDKImport_##Name)
@@ -0,0 +1,86 @@
+#include "UDKImportTask.h"
+#include "UDKImportPluginPrivatePCH.h"
+#include "Containers/Ticker.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Widgets/Notifications/SNotificationList.h"
+#include "T3DLevelParser.h"
+
+#define LOCTEXT_NAMESPACE "UDKImportPlugin"
+
+TWeakPtr<FUDKImportTask> FUDKImportTask::RunningTask;
+
+bool FUDKImportTask::Start(TUniquePtr<T3DLevelParser> Parser)
+{
+	if (IsRunning())
+		return false;
+
+	TSharedRef<FUDKImportTask> Task = MakeShareable(new FUDKImportTask(MoveTemp(Parser)));
+	RunningTask = Task;
+
+	FNotificationInfo Info(Task->Parser->GetImportStatus());
+	Info.bFireAndForget = false;
+	Info.bUseThrobber = true;
+	Info.ButtonDetails.Add(FNotificationButtonInfo(LOCTEXT("CancelImport", "Cancel"), LOCTEXT("CancelImportToolTip", "Stop the import and delete what it wrote"), FSimpleDelegate::CreateSP(Task, &FUDKImportTask::Cancel), SNotificationItem::CS_Pending));
+	Task->Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (Task->Notification.IsValid())
+	{
+		Task->Notification->SetCompletionState(SNotificationItem::CS_Pending);
+	}
+
+	// The ticker owns the task, it is released once Tick returns false
+	FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Task](float DeltaTime)
+	{
+		return Task->Tick(DeltaTime);
+	}));
+	return true;
+}
+
+bool FUDKImportTask::IsRunning()
+{
+	return RunningTask.IsValid();
+}
+
+FUDKImportTask::FUDKImportTask(TUniquePtr<T3DLevelParser> InParser)
+	: Parser(MoveTemp(InParser))
+{
+}
+
+FUDKImportTask::~FUDKImportTask()
+{
+}
+
+bool FUDKImportTask::Tick(float DeltaTime)
+{
+	const bool bFinished = Parser->TickImport(Parser->Settings.TickBudget);
+	if (!Notification.IsValid())
+		return !bFinished;
+
+	Notification->SetText(Parser->GetImportStatus());
+	if (bFinished)
+	{
+		Notification->SetCompletionState(Parser->IsImportCancelled() ? SNotificationItem::CS_Fail : SNotificationItem::CS_Success);
+		Notification->ExpireAndFadeout();
+	}
+	return !bFinished;
+}
+
+void FUDKImportTask::Cancel()
+{
+	Parser->CancelImport();
+	if (Notification.IsValid())
+	{
+		Notification->SetText(LOCTEXT("CancellingImport", "Cancelling import"));
+	}
+}
+
+void FUDKImportTask::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Parser->AddReferencedObjects(Collector);
+}
+
+FString FUDKImportTask::GetReferencerName() const
+{
+	return TEXT("FUDKImportTask");
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+
+class T3DLevelParser;
+class SNotificationItem;
+
+/**
+ * Runs an import from the editor without freezing it.
+ *
+ * The parser is ticked on the game thread for a few milliseconds per frame, T3D files are read on worker threads.
+ * A notification shows the progress of the import and lets the user cancel it.
+ */
+class FUDKImportTask : public FGCObject, public TSharedFromThis<FUDKImportTask>
+{
+public:
+	/** Take over a parser whose import was begun, fails if another import is running */
+	static bool Start(TUniquePtr<T3DLevelParser> Parser);
+
+	static bool IsRunning();
+
+	virtual ~FUDKImportTask();
+
+	/** FGCObject interface */
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override;
+
+private:
+	FUDKImportTask(TUniquePtr<T3DLevelParser> InParser);
+
+	bool Tick(float DeltaTime);
+	void Cancel();
+
+	TUniquePtr<T3DLevelParser> Parser;
+	TSharedPtr<SNotificationItem> Notification;
+
+	static TWeakPtr<FUDKImportTask> RunningTask;
+};
\ No newline at end of file
@@ -44,6 +44,12 @@ public class UDKImportPlugin : ModuleRules
 				"InputCore",
 				"UnrealEd",
 				"LevelEditor",
+				"Json",
+				"AssetRegistry",
+				"MessageLog",
+				"HierarchicalLODUtilities",
+				"MeshDescription",
+				"StaticMeshDescription",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,129 @@
+// Microbenchmarks of the engine-free T3D parsing core, see Source/UDKImportPlugin/Private/T3DCore/CMakeLists.txt
+
+#include "T3DCore/T3DLineParser.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace T3DCore;
+
+namespace
+{
+	/** Lines as exported by UDK for a static mesh actor, a brush polygon and a material expression */
+	std::vector<std::string> SampleLines()
+	{
+		return {
+			"      Begin Actor Class=StaticMeshActor Name=StaticMeshActor_1234 Archetype=StaticMeshActor'Engine.Default__StaticMeshActor'",
+			"         StaticMesh=StaticMesh'Castle.Meshes.SM_Wall_01'",
+			"            Origin   -00512.000000,-00256.000000,+00128.000000",
+			"            Vertex   +00512.000000,-00256.000000,+00128.000000",
+			"      Location=(X=1536.000000,Y=-2048.000000,Z=96.000000)",
+			"      Begin Object Class=MaterialExpressionTextureSample Name=MaterialExpressionTextureSample_7",
+			"         Coordinates=(Expression=MaterialExpressionTextureCoordinate'MaterialExpressionTextureCoordinate_2')",
+			"         Desc=\"Diffuse \\\"base\\\" layer\"",
+			"      End Object",
+			"      End Actor",
+		};
+	}
+}
+
+static void BM_TrimAndDepth(benchmark::State &State)
+{
+	const std::vector<std::string> Lines = SampleLines();
+	for (auto _ : State)
+	{
+		int Depth = 0;
+		for (const std::string &Line : Lines)
+		{
+			TSpan<char> Trimmed = Trim(Line.data(), Line.data() + Line.size());
+			Depth += LineDepthDelta(Trimmed.Begin, Trimmed.End);
+		}
+		benchmark::DoNotOptimize(Depth);
+	}
+	State.SetItemsProcessed(State.iterations() * Lines.size());
+}
+BENCHMARK(BM_TrimAndDepth);
+
+static void BM_GetOneValueAfter(benchmark::State &State)
+{
+	const std::vector<std::string> Lines = SampleLines();
+	static const char * Keys[] = { "Name=", "Class=", "X=", "Coordinates=", "Desc=" };
+	for (auto _ : State)
+	{
+		size_t Found = 0;
+		for (const std::string &Line : Lines)
+		{
+			for (const char * Key : Keys)
+			{
+				TSpan<char> Value;
+				Found += GetOneValueAfter(Line.data(), Line.data() + Line.size(), Key, std::strlen(Key), Value) ? Value.Len() : 0;
+			}
+		}
+		benchmark::DoNotOptimize(Found);
+	}
+	State.SetItemsProcessed(State.iterations() * Lines.size() * (sizeof(Keys) / sizeof(Keys[0])));
+}
+BENCHMARK(BM_GetOneValueAfter);
+
+static void BM_IsProperty(benchmark::State &State)
+{
+	const std::vector<std::string> Lines = SampleLines();
+	for (auto _ : State)
+	{
+		size_t Properties = 0;
+		for (const std::string &Line : Lines)
+		{
+			TSpan<char> Trimmed = Trim(Line.data(), Line.data() + Line.size());
+			TSpan<char> Name, Value;
+			Properties += IsProperty(Trimmed.Begin, Trimmed.End, Name, Value);
+		}
+		benchmark::DoNotOptimize(Properties);
+	}
+	State.SetItemsProcessed(State.iterations() * Lines.size());
+}
+BENCHMARK(BM_IsProperty);
+
+static void BM_ParseRessourceUrl(benchmark::State &State)
+{
+	const std::string Url = "StaticMesh'Castle.Meshes.Walls.SM_Wall_01'";
+	for (auto _ : State)
+	{
+		TRessourceUrl<char> Parsed;
+		benchmark::DoNotOptimize(ParseRessourceUrl(Url.data(), Url.data() + Url.size(), Parsed));
+		benchmark::DoNotOptimize(Parsed.Name.Begin);
+	}
+	State.SetItemsProcessed(State.iterations());
+}
+BENCHMARK(BM_ParseRessourceUrl);
+
+static void BM_ParseFloat(benchmark::State &State)
+{
+	static const char * Values[] = { "-00512.000000", "1536.000000", "0.5", "6.02214076e23", "-1.5e-7", "3" };
+	for (auto _ : State)
+	{
+		double Sum = 0.0;
+		for (const char * Value : Values)
+		{
+			Sum += ParseFloat(Value);
+		}
+		benchmark::DoNotOptimize(Sum);
+	}
+	State.SetItemsProcessed(State.iterations() * (sizeof(Values) / sizeof(Values[0])));
+}
+BENCHMARK(BM_ParseFloat);
+
+static void BM_ParseVector(benchmark::State &State)
+{
+	const char * Vector = "+00512.000000,-00256.000000,+00128.000000";
+	for (auto _ : State)
+	{
+		double X, Y, Z;
+		benchmark::DoNotOptimize(ParseVector(Vector, X, Y, Z));
+		benchmark::DoNotOptimize(X + Y + Z);
+	}
+	State.SetItemsProcessed(State.iterations());
+}
+BENCHMARK(BM_ParseVector);
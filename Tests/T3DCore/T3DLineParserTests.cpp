@@ -0,0 +1,290 @@
+// Unit tests of the engine-free T3D parsing core, see Source/UDKImportPlugin/Private/T3DCore/CMakeLists.txt
+
+#include "T3DCore/T3DLineParser.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace T3DCore;
+
+namespace
+{
+	std::string ToString(const TSpan<char> &Span)
+	{
+		return std::string(Span.Begin, Span.Len());
+	}
+
+	TSpan<char> TrimString(const char * String)
+	{
+		return Trim(String, String + std::strlen(String));
+	}
+
+	bool GetValue(const char * Line, const char * Key, std::string &Value, size_t MaxIndex = (size_t)-1)
+	{
+		TSpan<char> Span;
+		if (!GetOneValueAfter(Line, Line + std::strlen(Line), Key, std::strlen(Key), Span, MaxIndex))
+			return false;
+		Value = ToString(Span);
+		return true;
+	}
+
+	double ParseFloatEnd(const char * String, size_t &Consumed)
+	{
+		const char * End = nullptr;
+		const double Value = ParseFloat(String, &End);
+		Consumed = (size_t)(End - String);
+		return Value;
+	}
+}
+
+/// Trim and depth tracking
+
+TEST(Trim, StripsSpacesTabsAndCarriageReturns)
+{
+	EXPECT_EQ("Begin Actor", ToString(TrimString(" \t Begin Actor\t\r")));
+	EXPECT_EQ("a b", ToString(TrimString("a b")));
+	EXPECT_TRUE(TrimString(" \t\r ").IsEmpty());
+	EXPECT_TRUE(TrimString("").IsEmpty());
+}
+
+TEST(LineDepthDelta, BeginAndEndOnly)
+{
+	const char * Lines[] = { "Begin Object Class=Foo", "End Object", "BeginPlay", "Ending", "Name=Begin " };
+	const int Expected[] = { 1, -1, 0, 0, 0 };
+	for (size_t Index = 0; Index < sizeof(Expected) / sizeof(Expected[0]); ++Index)
+	{
+		const char * Line = Lines[Index];
+		EXPECT_EQ(Expected[Index], LineDepthDelta(Line, Line + std::strlen(Line))) << Line;
+	}
+}
+
+/// Values and properties
+
+TEST(GetOneValueAfter, Token)
+{
+	std::string Value;
+	ASSERT_TRUE(GetValue("Begin Actor Class=StaticMeshActor Name=Mesh_12 Archetype=Foo", "Name=", Value));
+	EXPECT_EQ("Mesh_12", Value);
+	ASSERT_TRUE(GetValue("Location=(X=1.5,Y=2)", "X=", Value));
+	EXPECT_EQ("1.5", Value);
+	ASSERT_TRUE(GetValue("Location=(X=1.5,Y=2)", "Y=", Value));
+	EXPECT_EQ("2", Value);
+	ASSERT_TRUE(GetValue("Name=", "Name=", Value));
+	EXPECT_EQ("", Value);
+}
+
+TEST(GetOneValueAfter, QuotedWithEscapes)
+{
+	std::string Value;
+	ASSERT_TRUE(GetValue("Desc=\"a \\\"quoted\\\" (value)\" Next=1", "Desc=", Value));
+	EXPECT_EQ("a \\\"quoted\\\" (value)", Value);
+	ASSERT_TRUE(GetValue("Desc=\"unterminated", "Desc=", Value));
+	EXPECT_EQ("unterminated", Value);
+}
+
+TEST(GetOneValueAfter, NestedParentheses)
+{
+	std::string Value;
+	ASSERT_TRUE(GetValue("Input=(Expression=Foo,Mask=(R=1,G=0)) Tail", "Input=", Value));
+	EXPECT_EQ("(Expression=Foo,Mask=(R=1,G=0))", Value);
+	ASSERT_TRUE(GetValue("Input=(Unbalanced", "Input=", Value));
+	EXPECT_EQ("(Unbalanced", Value);
+}
+
+TEST(GetOneValueAfter, MissingOrPastMaxIndex)
+{
+	std::string Value;
+	EXPECT_FALSE(GetValue("Name=Foo", "Class=", Value));
+	EXPECT_FALSE(GetValue("Begin Actor Name=Foo", "Name=", Value, 5));
+	EXPECT_TRUE(GetValue("Begin Actor Name=Foo", "Name=", Value, 12));
+	EXPECT_EQ("Foo", Value);
+}
+
+TEST(IsProperty, SplitsOnFirstEqual)
+{
+	const char * Line = "Texture=Texture2D'Pkg.Tex=1'";
+	TSpan<char> Name, Value;
+	ASSERT_TRUE(IsProperty(Line, Line + std::strlen(Line), Name, Value));
+	EXPECT_EQ("Texture", ToString(Name));
+	EXPECT_EQ("Texture2D'Pkg.Tex=1'", ToString(Value));
+
+	const char * NoName = "=Value";
+	EXPECT_FALSE(IsProperty(NoName, NoName + std::strlen(NoName), Name, Value));
+	const char * NoEqual = "Begin Object";
+	EXPECT_FALSE(IsProperty(NoEqual, NoEqual + std::strlen(NoEqual), Name, Value));
+}
+
+/// Ressource urls
+
+TEST(ParseRessourceUrl, WithPackageAndGroups)
+{
+	const char * Line = "Material'Pkg.Group.Mat_01'";
+	TRessourceUrl<char> Url;
+	ASSERT_TRUE(ParseRessourceUrl(Line, Line + std::strlen(Line), Url));
+	EXPECT_EQ("Material", ToString(Url.Type));
+	EXPECT_TRUE(Url.bHasPackage);
+	EXPECT_EQ("Pkg.Group", ToString(Url.Package));
+	EXPECT_EQ("Mat_01", ToString(Url.Name));
+}
+
+TEST(ParseRessourceUrl, WithoutPackage)
+{
+	const char * Line = "Texture2D'Tex'";
+	TRessourceUrl<char> Url;
+	ASSERT_TRUE(ParseRessourceUrl(Line, Line + std::strlen(Line), Url));
+	EXPECT_EQ("Texture2D", ToString(Url.Type));
+	EXPECT_FALSE(Url.bHasPackage);
+	EXPECT_TRUE(Url.Package.IsEmpty());
+	EXPECT_EQ("Tex", ToString(Url.Name));
+}
+
+TEST(ParseRessourceUrl, Malformed)
+{
+	TRessourceUrl<char> Url;
+	const char * NoQuote = "None";
+	EXPECT_FALSE(ParseRessourceUrl(NoQuote, NoQuote + std::strlen(NoQuote), Url));
+	const char * Unterminated = "Material'Pkg.Mat";
+	EXPECT_FALSE(ParseRessourceUrl(Unterminated, Unterminated + std::strlen(Unterminated), Url));
+	const char * Empty = "";
+	EXPECT_FALSE(ParseRessourceUrl(Empty, Empty, Url));
+
+	const char * SingleQuote = "'";
+	ASSERT_TRUE(ParseRessourceUrl(SingleQuote, SingleQuote + 1, Url));
+	EXPECT_TRUE(Url.Type.IsEmpty());
+	EXPECT_TRUE(Url.Name.IsEmpty());
+}
+
+/// ParseFloat
+
+TEST(ParseFloat, MatchesStrtod)
+{
+	const char * Values[] = {
+		"0", "1", "-1", "+2.5", "0.1", "0.2", "0.3", "3.14159265358979", "-0.000123", "123456.789",
+		"1e10", "1E-5", "-2.5e+3", "6.02214076e23", "1.7976931348623157e308", "2.2250738585072014e-308",
+		"12345678901234567890", "0.00000000000000000000123", "340282346638528859811704183484516925440", ".5", "5.",
+	};
+	for (const char * String : Values)
+	{
+		const double Expected = std::strtod(String, nullptr);
+		const double Value = ParseFloat(String);
+		EXPECT_NEAR(Expected, Value, std::fabs(Expected) * 4 * std::numeric_limits<double>::epsilon()) << String;
+	}
+}
+
+TEST(ParseFloat, ExactForShortDecimals)
+{
+	EXPECT_EQ(0.1, ParseFloat("0.1"));
+	EXPECT_EQ(-256.75, ParseFloat("-256.75"));
+	EXPECT_EQ(1e22, ParseFloat("1e22"));
+	EXPECT_EQ(1.5e-7, ParseFloat("1.5e-7"));
+}
+
+TEST(ParseFloat, SkipsEveryLeadingWhitespace)
+{
+	EXPECT_EQ(3.5, ParseFloat(" \t\n\v\f\r3.5"));
+	size_t Consumed = 0;
+	EXPECT_EQ(-4.0, ParseFloatEnd("\n-4,", Consumed));
+	EXPECT_EQ(3u, Consumed);
+}
+
+TEST(ParseFloat, NothingToParse)
+{
+	size_t Consumed = 1;
+	EXPECT_EQ(0.0, ParseFloatEnd("", Consumed));
+	EXPECT_EQ(0u, Consumed);
+	EXPECT_EQ(0.0, ParseFloatEnd("abc", Consumed));
+	EXPECT_EQ(0u, Consumed);
+	EXPECT_EQ(0.0, ParseFloatEnd("-", Consumed));
+	EXPECT_EQ(0u, Consumed);
+	EXPECT_EQ(0.0, ParseFloatEnd(" .e5", Consumed));
+	EXPECT_EQ(1u, Consumed);
+}
+
+TEST(ParseFloat, IncompleteExponentIsLeftUnread)
+{
+	size_t Consumed = 0;
+	EXPECT_EQ(2.0, ParseFloatEnd("2e", Consumed));
+	EXPECT_EQ(1u, Consumed);
+	EXPECT_EQ(2.0, ParseFloatEnd("2e+,", Consumed));
+	EXPECT_EQ(1u, Consumed);
+	EXPECT_EQ(20.0, ParseFloatEnd("2.E1x", Consumed));
+	EXPECT_EQ(4u, Consumed);
+}
+
+TEST(ParseFloat, HugeExponentsSaturate)
+{
+	EXPECT_EQ(0.0, ParseFloat("1e-400"));
+	EXPECT_EQ(std::numeric_limits<double>::infinity(), ParseFloat("1e400"));
+	EXPECT_EQ(-std::numeric_limits<double>::infinity(), ParseFloat("-1e400"));
+	EXPECT_GT(ParseFloat("1e-310"), 0.0);
+	EXPECT_NEAR(1e-310, ParseFloat("1e-310"), 1e-320);
+
+	// Exponents overflowing an int, consumed whole
+	size_t Consumed = 0;
+	EXPECT_EQ(std::numeric_limits<double>::infinity(), ParseFloatEnd("1e99999999999999999999 ", Consumed));
+	EXPECT_EQ(22u, Consumed);
+	EXPECT_EQ(0.0, ParseFloat("1e-99999999999999999999"));
+	EXPECT_EQ(0.0, ParseFloat("0e99999999999999999999"));
+}
+
+TEST(ParseFloat, HugeExponentDoesNotLoop)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	EXPECT_EQ(0.0, ParseFloat("1e-2000000000"));
+	EXPECT_EQ(std::numeric_limits<double>::infinity(), ParseFloat("1e2000000000"));
+	const auto Elapsed = std::chrono::steady_clock::now() - Start;
+	EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(Elapsed).count(), 100);
+}
+
+TEST(ParseFloat, LongMantissas)
+{
+	// Digits past the precision of a double move the decimal point only
+	const std::string Integer = "1" + std::string(400, '0');
+	EXPECT_EQ(std::numeric_limits<double>::infinity(), ParseFloat(Integer.c_str()));
+	const std::string Scaled = Integer + "e-400";
+	EXPECT_NEAR(1.0, ParseFloat(Scaled.c_str()), 1e-15);
+	const std::string Fraction = "0." + std::string(400, '0') + "1e401";
+	EXPECT_NEAR(1.0, ParseFloat(Fraction.c_str()), 1e-15);
+	EXPECT_NEAR(1.0 / 3.0, ParseFloat("0.333333333333333333333333333333333"), 1e-16);
+}
+
+TEST(ParseFloat, WideCharacters)
+{
+	const wchar_t * String = L"\t-1.25e2,";
+	const wchar_t * End = nullptr;
+	EXPECT_EQ(-125.0, ParseFloat(String, &End));
+	EXPECT_EQ(L',', *End);
+	EXPECT_EQ(0.5, ParseFloat(u"0.5"));
+}
+
+/// Vectors
+
+TEST(ParseVector, ThreeComponents)
+{
+	double X, Y, Z;
+	ASSERT_TRUE(ParseVector("+00128.000000,-00064.500000,+00000.250000", X, Y, Z));
+	EXPECT_EQ(128.0, X);
+	EXPECT_EQ(-64.5, Y);
+	EXPECT_EQ(0.25, Z);
+	ASSERT_TRUE(ParseVector(" 1, 2 ,\t3", X, Y, Z));
+	EXPECT_EQ(1.0, X);
+	EXPECT_EQ(2.0, Y);
+	EXPECT_EQ(3.0, Z);
+}
+
+TEST(ParseVector, MissingComponentsStayZero)
+{
+	double X = 9, Y = 9, Z = 9;
+	EXPECT_FALSE(ParseVector("4,5", X, Y, Z));
+	EXPECT_EQ(4.0, X);
+	EXPECT_EQ(5.0, Y);
+	EXPECT_EQ(0.0, Z);
+	EXPECT_FALSE(ParseVector("", X, Y, Z));
+	EXPECT_EQ(0.0, X);
+}